@@ -0,0 +1,67 @@
+#ifndef ACCOUNT_STORE_H
+#define ACCOUNT_STORE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <unordered_map>
+
+using namespace std;
+
+// AccountStore Class
+// Keeps every account in one segmented file instead of one file per user.
+// The file starts with a small header, followed by segments of the form
+//
+//   AccountSegment header | payload (capacity bytes, first `length` used)
+//
+// The payload is the same BORROW/HISTORY/FINE text as the old per-user
+// account files. An update is written in place when it fits the segment's
+// capacity; otherwise a larger segment is appended and the old one is marked
+// free. The offset index is rebuilt from the segment headers on open.
+class AccountStore {
+private:
+    struct Segment {
+        int32_t userID;
+        uint32_t flags;
+        uint32_t capacity;
+        uint32_t length;
+    };
+
+    struct Location {
+        uint64_t offset;
+        uint32_t capacity;
+    };
+
+    static const uint32_t SEGMENT_LIVE = 1;
+    static const uint32_t MIN_CAPACITY = 64;
+
+    string path;
+    fstream file;
+    unordered_map<int, Location> index;
+    uint64_t fileSize;
+    uint64_t liveBytes;
+
+    bool writeSegment(uint64_t offset, const Segment& segment, const string& payload);
+    bool markFree(uint64_t offset);
+
+public:
+    explicit AccountStore(const string& path);
+
+    bool open();
+    bool isOpen() const;
+    void close();
+
+    bool contains(int userID) const;
+    bool read(int userID, string& payload);
+    bool write(int userID, const string& payload);
+    bool remove(int userID);
+    unordered_map<int, string> readAll();
+    vector<int> getUserIDs() const;
+
+    bool needsCompaction() const;
+    bool compact();
+    const string& getPath() const;
+};
+
+#endif // ACCOUNT_STORE_H
@@ -0,0 +1,86 @@
+#ifndef BOOK_COLUMNS_H
+#define BOOK_COLUMNS_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include "StringPool.h"
+#include "TextScan.h"
+
+using namespace std;
+
+class Book;
+
+// BookColumns Class
+// Column-oriented copy of the catalog for full scans. Rows are appended in
+// insertion order and hold the book ID, year, interned author and publisher
+// handles, availability bit and an offset into a shared text arena, plus a
+// pointer back to the owning Book. Each
+// row's arena text is its lowercased "title\nauthor", so substring filters
+// run over one contiguous buffer without touching the Book objects.
+//
+// Removed books leave a tombstone until more than half the rows are dead,
+// at which point the columns are compacted. Structural changes need the
+// catalog lock exclusively; availability bits are atomic so they can be
+// flipped under the book stripe locks alone.
+class BookColumns {
+private:
+    static const size_t BITS_PER_WORD = 64;
+
+public:
+    static const size_t NO_ROW = SIZE_MAX;
+
+private:
+
+    // Arena size above which findText splits the scan across threads
+    static const size_t PARALLEL_SCAN_BYTES = 1 << 20;
+
+    vector<int> ids;
+    vector<int> years;
+    vector<StringHandle> authors;
+    vector<StringHandle> publishers;
+    vector<size_t> textOffsets;
+    vector<size_t> textLengths;
+    vector<const Book*> rows;
+    vector<uint64_t> liveBits;
+    deque<atomic<uint64_t>> availableBits;
+    string arena;
+    unordered_map<int, size_t> rowOf;
+    size_t liveCount;
+
+    void setBit(size_t row, bool value);
+    void scanRows(const TextScan& scan, size_t begin, size_t end, vector<const Book*>& matches) const;
+
+public:
+    BookColumns();
+
+    void append(const Book& book);
+    bool erase(int bookID);
+    void setAvailable(int bookID, bool available);
+    void clear();
+    void compact();
+
+    size_t rowCount() const;
+    size_t size() const;
+    bool isLive(size_t row) const;
+    bool isAvailable(size_t row) const;
+    int getBookID(size_t row) const;
+    int getYear(size_t row) const;
+    StringHandle getAuthorHandle(size_t row) const;
+    StringHandle getPublisherHandle(size_t row) const;
+    const Book* getBook(size_t row) const;
+    string_view getSearchText(size_t row) const;
+    const string& getArena() const;
+    size_t getTextOffset(size_t row) const;
+    size_t findRow(int bookID) const;  // NO_ROW if the book has no live row
+
+    // Live books whose title or author contains `needle`, ignoring ASCII
+    // case, in insertion order
+    vector<const Book*> findText(string_view needle) const;
+};
+
+#endif // BOOK_COLUMNS_H
@@ -0,0 +1,138 @@
+#ifndef DATA_PARSER_H
+#define DATA_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+using namespace std;
+
+// DataLine Class
+// One delimited record. Fields are views into the parser's buffer and are
+// only valid during the callback; copy with str() to keep them.
+class DataLine {
+private:
+    vector<string_view> fields;
+    size_t number;
+
+    friend class DataParser;
+
+public:
+    DataLine() : number(0) {}
+
+    size_t size() const { return fields.size(); }
+    string_view operator[](size_t index) const { return fields[index]; }
+    string str(size_t index) const { return string(fields[index]); }
+    size_t getLineNumber() const { return number; }
+
+    // Whole-field numeric conversions; false if the field is not a number
+    bool getInt(size_t index, int& value) const;
+    bool getInt64(size_t index, int64_t& value) const;
+    bool getDouble(size_t index, double& value) const;
+};
+
+// DataParser Class
+// Shared reader for the pipe-delimited data files. Files are read in large
+// chunks and split in place into string_views, so no string is allocated
+// per line or per field. Trailing whitespace and carriage returns are
+// stripped, and blank lines and lines starting with '#' are skipped.
+//
+// The callback receives each record and returns false if the record is
+// malformed. Malformed records are reported on stderr with their line
+// number (the first few individually, then a total) and parsing carries on.
+class DataParser {
+private:
+    static const size_t CHUNK_SIZE = 1 << 20;
+    static const size_t MAX_REPORTED_ERRORS = 10;
+
+    string source;
+    char delimiter;
+    size_t lineNumber;
+    size_t recordCount;
+    size_t errorCount;
+    DataLine line;
+
+    template<typename Func>
+    void parseLine(string_view text, Func& callback);
+    void reportError();
+    void finish();
+
+public:
+    explicit DataParser(const string& source, char delimiter = '|');
+
+    // Parse the file named by the source; returns false if it cannot be opened
+    template<typename Func>
+    bool parseFile(Func&& callback);
+
+    // Parse text already in memory
+    template<typename Func>
+    void parseText(string_view text, Func&& callback);
+
+    size_t getRecordCount() const { return recordCount; }
+    size_t getErrorCount() const { return errorCount; }
+
+    static void split(string_view text, char delimiter, vector<string_view>& fields);
+};
+
+template<typename Func>
+void DataParser::parseLine(string_view text, Func& callback) {
+    ++lineNumber;
+    size_t end = text.find_last_not_of(" \t\r");
+    if (end == string_view::npos || text[0] == '#') return;
+
+    split(text.substr(0, end + 1), delimiter, line.fields);
+    line.number = lineNumber;
+    ++recordCount;
+    if (!callback(static_cast<const DataLine&>(line))) {
+        reportError();
+    }
+}
+
+template<typename Func>
+bool DataParser::parseFile(Func&& callback) {
+    ifstream file(source, ios::binary);
+    if (!file.is_open()) return false;
+
+    // Complete lines are parsed straight out of the buffer; a partial line
+    // at the end of a chunk is moved to the front and finished by the next
+    string buffer;
+    size_t carried = 0;
+    while (true) {
+        buffer.resize(carried + CHUNK_SIZE);
+        file.read(&buffer[carried], CHUNK_SIZE);
+        size_t filled = carried + static_cast<size_t>(file.gcount());
+        string_view data(buffer.data(), filled);
+
+        size_t start = 0;
+        size_t newline;
+        while ((newline = data.find('\n', start)) != string_view::npos) {
+            parseLine(data.substr(start, newline - start), callback);
+            start = newline + 1;
+        }
+
+        if (!file) {
+            if (start < filled) parseLine(data.substr(start), callback);
+            break;
+        }
+        carried = filled - start;
+        buffer.erase(0, start);
+    }
+    finish();
+    return true;
+}
+
+template<typename Func>
+void DataParser::parseText(string_view text, Func&& callback) {
+    size_t start = 0;
+    size_t newline;
+    while ((newline = text.find('\n', start)) != string_view::npos) {
+        parseLine(text.substr(start, newline - start), callback);
+        start = newline + 1;
+    }
+    if (start < text.size()) parseLine(text.substr(start), callback);
+    finish();
+}
+
+#endif // DATA_PARSER_H
@@ -0,0 +1,94 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+using namespace std;
+
+// How hard the journal writer pushes each batch towards the disk
+enum class JournalSync {
+    NONE,        // hand batches to the OS and let it write them back
+    EVERY_BATCH  // fsync after every batch
+};
+
+// Journal Class
+// Append-only write-ahead log of library mutations. Every record is a single
+// pipe-delimited line in the same style as the other data files. The journal
+// only holds changes made since the last checkpoint; when a checkpoint is
+// written, the records it covers are cut from the front of the journal. A
+// record left half-written by a crash is cut from the end by recover()
+// before the journal is replayed.
+//
+// Records are group-committed: append() only queues the record in memory and
+// returns its sequence number. A background writer wakes every flush interval
+// (or sooner once enough bytes are queued), writes everything queued so far in
+// one call and, depending on the sync policy, fsyncs it. Once a batch is
+// written the durable sequence advances to its last record, so a caller that
+// needs a record on disk can wait for its sequence number. A batch that fails
+// to write is removed from the file again and retried.
+class Journal {
+private:
+    static const size_t MAX_PENDING_BYTES = 1 << 20;
+
+    string path;
+    FILE* file;
+    size_t recordCount;
+    chrono::milliseconds flushInterval;
+    JournalSync syncPolicy;
+
+    // Queue shared with the writer thread
+    mutable mutex queueMutex;
+    condition_variable writerWake;
+    condition_variable durableAdvanced;
+    string pending;
+    uint64_t lastSequence;
+    uint64_t baseSequence;  // sequence just before the first record in the file
+    atomic<uint64_t> durableSequence;
+    bool flushRequested;
+    bool stopping;
+    thread writer;
+
+    // Held while a batch is written so truncateThrough() cannot cut under it
+    mutex fileMutex;
+    bool writeFailed;  // the last batch failed to write; under fileMutex
+
+    void writerLoop();
+    bool writeBatch(const string& batch, JournalSync policy);
+
+public:
+    // Last field of a record cut short by a crash that could not be removed
+    static const char* const TORN_MARKER;
+
+    explicit Journal(const string& path);
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Durability helpers, also used for the snapshot: push a written file
+    // to the disk, and make a rename into the directory of `path` durable
+    static bool syncFile(FILE* file);
+    static bool syncDirectory(const string& path);
+
+    void configure(chrono::milliseconds interval, JournalSync policy);
+    size_t recover();
+    bool open(size_t existingRecords);
+    void close();
+    bool isOpen() const;
+    uint64_t append(const string& record);
+    bool waitDurable(uint64_t sequence);
+    void truncateThrough(uint64_t sequence);
+    size_t size() const;
+    uint64_t getLastSequence() const;
+    uint64_t getDurableSequence() const;
+    const string& getPath() const;
+};
+
+#endif // JOURNAL_H
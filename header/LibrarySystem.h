@@ -4,9 +4,28 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <queue>
+#include <list>
+#include <algorithm>
+#include <set>
+#include <tuple>
+#include <functional>
 #include <unordered_map>
+#include <unordered_set>
 #include <chrono>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include "Journal.h"
+#include "AccountStore.h"
+#include "BookColumns.h"
+#include "StringPool.h"
+#include "ObjectPool.h"
+#include "RolePolicy.h"
+#include "PrefixTrie.h"
+#include "TrigramIndex.h"
 
 using namespace std;
 
@@ -27,37 +46,102 @@ struct BorrowInfo {
     chrono::system_clock::time_point dueDate;
 };
 
+// Completion Structure
+// One autocomplete suggestion: the completed query, how many books match it
+// and the first few of their IDs.
+struct Completion {
+    string text;
+    size_t bookCount;
+    vector<int> bookIDs;
+};
+
+// LoanQuery Structure
+// One page request over current loans, returned in due-date order. Leave
+// resumeToken empty for the first page and pass back LoanPage::nextToken for
+// the following ones. Empty filters match every borrower.
+struct LoanQuery {
+    size_t pageSize = 20;
+    string resumeToken;
+    string role;
+    string department;
+};
+
+// LoanPage Structure
+struct LoanPage {
+    vector<BorrowInfo> loans;
+    string nextToken;  // empty once the last page has been returned
+};
+
+// ReservationQueue Class
+// First-come-first-served queue of user IDs that also supports O(1)
+// membership checks and O(1) removal from any position.
+class ReservationQueue {
+private:
+    list<int> order;
+    unordered_map<int, list<int>::iterator> positions;
+
+public:
+    ReservationQueue() = default;
+    ReservationQueue(const ReservationQueue& other);
+    ReservationQueue& operator=(const ReservationQueue& other);
+
+    bool push(int userID);
+    bool remove(int userID);
+    int pop();
+    int front() const;
+    bool contains(int userID) const;
+    bool empty() const;
+    size_t size() const;
+    const list<int>& getOrder() const;
+};
+
 // Book Class
+// One bibliographic record holding every physical copy of a title. The
+// number of copies on the shelf is an atomic counter, so "is any copy
+// available" is a single load; copies are checked out and in under the
+// book's stripe lock. All copies share one reservation queue.
 class Book {
 private:
     int bookID;
     string title;
-    string author;
-    string publisher;
+    StringHandle author;
+    StringHandle publisher;
     int year;
     string ISBN;
-    bool available;
-    queue<int> reservationQueue;
+    int copies;
+    atomic<int> availableCopies;
+    ReservationQueue reservationQueue;
 
 public:
+    // Library::insertBook rejects books with fewer copies than this
+    static const int MIN_COPIES = 1;
+
     Book(int id, const string& title, const string& author, 
-         const string& publisher, int year, const string& isbn);
+         const string& publisher, int year, const string& isbn, int copies = 1);
     
     int getBookID() const;
-    string getTitle() const;
-    string getAuthor() const;
-    string getPublisher() const;
+    const string& getTitle() const;
+    const string& getAuthor() const;
+    const string& getPublisher() const;
+    StringHandle getAuthorHandle() const;
+    StringHandle getPublisherHandle() const;
     int getYear() const;
-    string getISBN() const;
+    const string& getISBN() const;
+    int getCopies() const;
+    int getAvailableCopies() const;
     bool isAvailable() const;
     bool isAvailableFor(int userID) const;
-    void setAvailable(bool status);
+    bool setCopies(int count);
+    bool checkOut();
+    void checkIn();
     
     bool reserve(int userID);
     bool cancelReservation(int userID);
     bool isReserved() const;
     int getNextReservation();
     bool isReservedBy(int userID) const;
+    vector<int> getReservations() const;
+    void restoreReservation(int userID);
 };
 
 // BorrowRecord Structure
@@ -78,7 +162,9 @@ private:
 public:
     Account(int id);
     
+    int getUserID() const;
     void addBorrow(int bookID);
+    void addBorrow(const BorrowRecord& record);
     void removeBorrow(int bookID);
     const vector<BorrowRecord>& getCurrentBorrows() const;
     const vector<BorrowRecord>& getBorrowHistory() const;
@@ -89,105 +175,266 @@ public:
 };
 
 // User Base Class
+// Permissions and limits come from the role policy table, so the checks on
+// the borrow and return paths are a table load rather than a virtual call.
 class User {
 protected:
     int userID;
     string name;
     string password;
-    string department;
-    string role;
+    StringHandle department;
+    RoleID role;
 
 public:
-    User(int id, const string& name, const string& password);
+    User(int id, const string& name, const string& password, RoleID role);
     virtual ~User() = default;
 
     int getUserID() const;
     string getName() const;
     string getRole() const;
-    string getDepartment() const;
+    RoleID getRoleID() const { return role; }
+    const RolePolicy& getPolicy() const { return RoleRegistry::get(role); }
+    const string& getDepartment() const;
+    StringHandle getDepartmentHandle() const;
     string getPassword() const { return password; }
     void setDepartment(const string& dept);
     bool verifyPassword(const string& pwd) const { return password == pwd; }
 
-    virtual bool canBorrow() const = 0;
-    virtual bool canManageBooks() const = 0;
-    virtual bool canManageUsers() const = 0;
-    virtual int getMaxBooks() const = 0;
-    virtual int getMaxDays() const = 0;
-    virtual double getFineRate() const = 0;
+    bool canBorrow() const { return getPolicy().canBorrow; }
+    bool canManageBooks() const { return getPolicy().canManageBooks; }
+    bool canManageUsers() const { return getPolicy().canManageUsers; }
+    int getMaxBooks() const { return getPolicy().maxBooks; }
+    int getMaxDays() const { return getPolicy().maxDays; }
+    double getFineRate() const { return getPolicy().fineRate; }
 };
 
 // Student Class
 class Student : public User {
-private:
-    static const int MAX_BOOKS = 3;
-    static const int MAX_DAYS = 15;
-    static constexpr double FINE_RATE = 10.0;
-
 public:
     Student(int id, const string& name, const string& password);
-    
-    bool canBorrow() const override { return true; }
-    bool canManageBooks() const override { return false; }
-    bool canManageUsers() const override { return false; }
-    int getMaxBooks() const override { return MAX_BOOKS; }
-    int getMaxDays() const override { return MAX_DAYS; }
-    double getFineRate() const override { return FINE_RATE; }
 };
 
 // Faculty Class
 class Faculty : public User {
-private:
-    static const int MAX_BOOKS = 5;
-    static const int MAX_DAYS = 30;
-    static constexpr double FINE_RATE = 0.0;
-    static const int MAX_OVERDUE_DAYS = 60;
-
 public:
     Faculty(int id, const string& name, const string& password);
-    
-    bool canBorrow() const override { return true; }
-    bool canManageBooks() const override { return true; }
-    bool canManageUsers() const override { return false; }
-    int getMaxBooks() const override { return MAX_BOOKS; }
-    int getMaxDays() const override { return MAX_DAYS; }
-    double getFineRate() const override { return FINE_RATE; }
 };
 
 // Librarian Class
 class Librarian : public User {
 public:
     Librarian(int id, const string& name, const string& password);
-    
-    bool canBorrow() const override { return false; }
-    bool canManageBooks() const override { return true; }
-    bool canManageUsers() const override { return true; }
-    int getMaxBooks() const override { return 0; }
-    int getMaxDays() const override { return 0; }
-    double getFineRate() const override { return 0.0; }
 };
 
 // Library Class
 class Library {
 private:
-    unordered_map<int, unique_ptr<Book>> books;
-    unordered_map<int, unique_ptr<User>> users;
-    unordered_map<int, unique_ptr<Account>> accounts;
+    // Slab pools for the entities the library creates itself; declared
+    // before the maps so they outlive every object they hold
+    SlabAllocator bookPool{sizeof(Book)};
+    SlabAllocator userPool{sizeof(User)};
+    SlabAllocator accountPool{sizeof(Account)};
+
+    unordered_map<int, PoolPtr<Book>> books;
+    unordered_map<int, PoolPtr<User>> users;
+    unordered_map<int, PoolPtr<Account>> accounts;
+    mutable Journal journal{"data/journal.txt"};
 
-    // Helper function declarations
-    static vector<string> split(const string& str, char delim);
-    template<typename Func>
-    void readDataFile(const string& filename, Func&& callback);
+    // Concurrency: the catalog lock guards the maps and the search index
+    // (shared for lookups and circulation, exclusive for adds, removes,
+    // loads and saves). Book and account state is guarded by striped locks
+    // keyed by bookID and userID.
+    static const size_t LOCK_STRIPES = 64;
+    mutable shared_mutex catalogMutex;
+    mutable array<shared_mutex, LOCK_STRIPES> bookLocks;
+    mutable array<shared_mutex, LOCK_STRIPES> accountLocks;
+
+    // Binary snapshot written by every checkpoint
+    static constexpr const char* SNAPSHOT_PATH = "data/library.snap";
+
+    // All accounts in one segmented file, written by saveState
+    mutable AccountStore accountStore{"data/accounts.dat"};
+
+    // Column copy of the catalog used by full scans
+    BookColumns bookColumns;
+
+    // Inverted index: normalized title/author term -> sorted bookIDs
+    unordered_map<string, vector<int>> searchIndex;
+
+    // How indexBook() treats the term index: maintained in place, appended to
+    // while a load inserts books in arbitrary order, or left alone because the
+    // snapshot already supplied it. finishBulkIndex() returns it to LIVE.
+    enum class IndexMode { LIVE, BULK, PRELOADED };
+    IndexMode indexMode = IndexMode::LIVE;
+
+    // Prefix trie over the index terms, weighted by posting list length
+    PrefixTrie termTrie;
+    static constexpr size_t COMPLETION_BOOK_LIMIT = 10;
+
+    // Trigrams of the index terms, for typo-tolerant lookups
+    TrigramIndex termGrams;
+
+    // ISBN index: normalized ISBN-13 as a number -> bookIDs sharing it
+    unordered_multimap<uint64_t, int> isbnIndex;
+
+    // Reverse reservation index: userID -> bookIDs the user has reserved.
+    // Guarded by its own mutex, taken after any book or account stripe.
+    unordered_map<int, unordered_set<int>> reservationsByUser;
+    mutable shared_mutex reservationIndexMutex;
+
+    // Due-date index: every current loan ordered by due date, so overdue
+    // queries stop at the first loan that is not yet due. Guarded by its own
+    // mutex, taken after any book or account stripe.
+    struct DueEntry {
+        chrono::system_clock::time_point dueDate;
+        int userID;
+        int bookID;
+        chrono::system_clock::time_point borrowDate;
+
+        bool operator<(const DueEntry& other) const {
+            return tie(dueDate, userID, bookID) < tie(other.dueDate, other.userID, other.bookID);
+        }
+    };
+    set<DueEntry> dueIndex;
+    mutable mutex dueIndexMutex;
+
+    // A mutation triggers a checkpoint once the journal holds at least
+    // CHECKPOINT_INTERVAL records and one record per CHECKPOINT_DIVISOR books
+    // and accounts. A checkpoint rewrites the whole catalog, so growing the
+    // interval with it keeps the cost per record constant, and replay stays
+    // a fixed fraction of the snapshot load.
+    static const size_t CHECKPOINT_INTERVAL = 1000;
+    static const size_t CHECKPOINT_DIVISOR = 4;
+
+    // Due checkpoints run on this thread, through a read view, so the
+    // mutation that crosses the threshold returns without waiting for the
+    // snapshot. checkpointMutex is taken after any other lock.
+    mutex checkpointMutex;
+    condition_variable checkpointWake;
+    bool checkpointDue = false;
+    bool checkpointStopping = false;
+    thread checkpointer;
+    void checkpointLoop();
+
+    // Change set: what saveState has to rewrite since the last save. The text
+    // files are rewritten whole, so each is tracked as one bit; accounts live
+    // in the account store and are rewritten one by one. Saved in snapshots
+    // so unsaved changes survive a restart. Guarded by its own mutex, taken
+    // after any book or account stripe.
+    static const uint64_t CHANGED_BOOKS = 1;
+    static const uint64_t CHANGED_RESERVATIONS = 2;
+    static uint64_t changedUserFile(RoleID role) {
+        return uint64_t(4) << min<RoleID>(role, BUILTIN_ROLE_COUNT);
+    }
+    mutable mutex changeMutex;
+    mutable uint64_t changedFiles = 0;
+    mutable unordered_set<int> changedAccounts;
+    void markChanged(uint64_t files);
+    void markAccountChanged(int userID);
+    void clearChanges();
+
+    // Copy-on-write read view for checkpoints, saves and full reports. While
+    // a view is open, the first change to a book's or an account's
+    // circulation state copies its pre-image into the view, so the reader
+    // sees the library as it was when the view began while borrows and
+    // returns carry on. The view holds the catalog lock shared, so adds and
+    // removes wait for it to end. One view is open at a time.
+    //
+    // Opening a view is not free: beginView() takes every book and account
+    // stripe once, so all circulation stops until the operations already
+    // holding a stripe finish. That is about 10 us on an idle library of any
+    // size, but it grows with contention and scheduling delays (0.35-0.7 ms
+    // on average, a few ms at worst, with four threads on one CPU).
+    struct BookImage {
+        int copies;
+        int availableCopies;
+        vector<int> reservations;
+    };
+    struct ReadView {
+        uint64_t journalSequence;   // last journal record the view includes
+        uint64_t changedFiles;      // change set as of the view
+        unordered_set<int> changedAccounts;
+        unordered_map<int, BookImage> books;
+        unordered_map<int, Account> accounts;
+    };
+    mutable mutex viewGate;
+    mutable mutex viewMutex;
+    mutable atomic<bool> viewActive{false};
+    mutable unique_ptr<ReadView> activeView;
+    void beginView(bool takeChanges) const;
+    unique_ptr<ReadView> endView() const;
+    void touchBook(const Book* book);
+    void touchAccount(const Account* account);
+    BookImage viewBook(const Book& book) const;
+    void viewAccount(const Account& account, const function<void(const Account&)>& reader) const;
+    bool writeTextState(const ReadView& view) const;
+
+    // Journal helpers: every mutation is appended as one record, and replay
+    // re-applies the same effects without re-running the validation checks.
+    void logMutation(const string& record);
+    void applyReturn(Account* account, Book* book, double fine);
+    bool checkOutCopy(Book* book);
+    void checkInCopy(Book* book);
+    bool applyReserve(Book* book, int userID);
+    bool applyCancel(Book* book, int userID);
+    void restoreReservation(Book* book, int userID);
+    void indexReservation(int userID, int bookID);
+    void unindexReservation(int userID, int bookID);
+    void indexLoan(int userID, const BorrowRecord& record);
+    void unindexLoan(int userID, const BorrowRecord& record);
+    bool visitLoans(const DueEntry* after, chrono::system_clock::time_point until,
+                    const function<bool(const DueEntry&, const BorrowInfo&)>& visitor) const;
+    void replayJournal();
+    void importTextState();
+
+    // Account loading helpers
+    PoolPtr<Account> parseAccountFile(int userID);
+    PoolPtr<Account> parseAccount(int userID, const string& text);
+    static string serializeAccount(const Account& account);
+    void attachAccount(PoolPtr<Account> account);
+    void loadAccounts(const vector<int>& userIDs);
+    PoolPtr<User> createUser(RoleID role, int userID, const string& name, const string& password);
+    void loadRoles();
+    bool saveRoles() const;
+
+    // Lock helpers and unlocked variants for callers holding the catalog lock
+    shared_mutex& bookStripe(int bookID) const;
+    shared_mutex& accountStripe(int userID) const;
+    Book* findBook(int bookID) const;
+    User* findUser(int userID) const;
+    Account* findAccount(int userID) const;
+    bool insertBook(PoolPtr<Book> book);
+    bool eraseBook(int bookID);
+    bool insertUser(PoolPtr<User> user);
+    bool eraseUser(int userID);
+
+    // Snapshot I/O. Saving reads through the open read view with the catalog
+    // lock held shared; loading holds it exclusively.
+    bool saveSnapshot(const string& path) const;
+    bool loadSnapshot(const string& path);
+
+    // Search index helpers
+    static vector<string> tokenize(const string& text);
+    void indexBook(const Book& book);
+    void unindexBook(const Book& book);
+    void finishBulkIndex();
+    bool findSubstringCandidates(const vector<string>& words, vector<int>& candidates) const;
 
 public:
-    Library() = default;
+    Library();
     ~Library();
 
     // Book management
     bool addBook(unique_ptr<Book> book);
     bool removeBook(int bookID);
+    bool setCopies(int bookID, int copies);
     const Book* getBook(int bookID) const;
+    const Book* getBookByISBN(const string& isbn) const;
     vector<const Book*> searchBooks(const string& query) const;
+    vector<const Book*> getAllBooks() const;
+    vector<Completion> autocomplete(const string& prefix, size_t limit) const;
+    vector<const Book*> fuzzySearch(const string& query, size_t limit) const;
+    vector<const Book*> getBooksByPublisher(const string& publisher) const;
 
     // User management
     bool addUser(unique_ptr<User> user);
@@ -205,9 +452,34 @@ public:
     vector<const Book*> getReservedBooks(int userID) const;
     vector<BorrowInfo> getAllBorrowedBooks() const;
 
+    // Overdue loans, most overdue first, read from the due-date index. The
+    // visitor returns false to stop early and must not modify the library.
+    size_t forEachOverdue(chrono::system_clock::time_point now,
+                          const function<bool(const BorrowInfo&)>& visitor) const;
+    vector<BorrowInfo> getOverdueBooks(chrono::system_clock::time_point now, size_t limit = 0) const;
+
+    // Paginated view of all current loans; memory use is bounded by the page size
+    bool getBorrowedBooksPage(const LoanQuery& query, LoanPage& page) const;
+
+    // Reduce an ISBN-10 or ISBN-13, with or without hyphens and spaces, to
+    // its ISBN-13 digits. Returns false if it is neither.
+    static bool normalizeISBN(const string& isbn, uint64_t& key);
+
+    // Roles beyond the built-in ones; saved to data/roles.txt
+    RoleID registerRole(const RolePolicy& policy);
+
+    // Journal durability. Mutations return once their record is queued; the
+    // journal writer group-commits queued records every flush interval.
+    // Sequence numbers count records since startup.
+    void configureJournal(chrono::milliseconds flushInterval, JournalSync policy);
+    uint64_t getLastSequence() const;
+    uint64_t getDurableSequence() const;
+    bool waitDurable(uint64_t sequence) const;
+
     // State management
-    void saveState() const;
-    void loadState();
+    bool saveState() const;
+    bool loadState();
+    void checkpoint();
     void loadAccountInfo(int userID);
 };
 
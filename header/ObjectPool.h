@@ -0,0 +1,97 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// SlabAllocator Class
+// Fixed-size slot allocator that carves objects out of large slabs. Each
+// new slab is twice the size of the previous one, so loading a big library
+// costs a handful of allocations. Freed slots go on a free list. Once every
+// slot is free, the allocator rewinds to the first slab and hands out slots
+// in order again; this keeps a cleared-and-reloaded library contiguous
+// without returning memory to the heap.
+class SlabAllocator {
+private:
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    static const size_t FIRST_SLAB_SLOTS = 256;
+    static const size_t MAX_SLAB_SLOTS = 65536;
+
+    size_t slotSize;
+    vector<unique_ptr<unsigned char[]>> slabs;
+    vector<size_t> slabSlots;
+    size_t currentSlab;
+    size_t nextSlot;
+    FreeSlot* freeList;
+    size_t liveCount;
+    mutable mutex poolMutex;
+
+public:
+    explicit SlabAllocator(size_t objectSize);
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    void* allocate();
+    void deallocate(void* slot);
+    size_t getSlotSize() const;
+    size_t size() const;
+    size_t capacity() const;
+};
+
+// PoolDeleter
+// Destroys an object and returns its slot to the allocator it came from.
+// Objects created outside a pool (e.g. handed to Library::addBook by a
+// caller) have no allocator and are deleted normally.
+template<typename T>
+struct PoolDeleter {
+    SlabAllocator* pool = nullptr;
+
+    PoolDeleter() = default;
+    explicit PoolDeleter(SlabAllocator* pool) : pool(pool) {}
+
+    void operator()(T* object) const {
+        if (!object) return;
+        if (pool) {
+            object->~T();
+            pool->deallocate(object);
+        } else {
+            delete object;
+        }
+    }
+};
+
+template<typename T>
+using PoolPtr = unique_ptr<T, PoolDeleter<T>>;
+
+// Construct a Derived in a slot of `pool` and own it as a T. Falls back to
+// the heap if Derived does not fit the pool's slots.
+template<typename T, typename Derived = T, typename... Args>
+PoolPtr<T> makePooled(SlabAllocator& pool, Args&&... args) {
+    if (sizeof(Derived) > pool.getSlotSize() || alignof(Derived) > alignof(max_align_t)) {
+        return PoolPtr<T>(new Derived(forward<Args>(args)...));
+    }
+    void* slot = pool.allocate();
+    try {
+        return PoolPtr<T>(new (slot) Derived(forward<Args>(args)...), PoolDeleter<T>(&pool));
+    } catch (...) {
+        pool.deallocate(slot);
+        throw;
+    }
+}
+
+// Take ownership of a heap object in a pool-aware pointer
+template<typename T>
+PoolPtr<T> adoptHeap(unique_ptr<T> object) {
+    return PoolPtr<T>(object.release());
+}
+
+#endif // OBJECT_POOL_H
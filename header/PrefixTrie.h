@@ -0,0 +1,47 @@
+#ifndef PREFIX_TRIE_H
+#define PREFIX_TRIE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
+
+using namespace std;
+
+// PrefixTrie Class
+// Compressed (radix) trie over search terms. Each term carries a weight,
+// the number of books it appears in, and every node caches the largest
+// weight below it. Completions of a prefix can then be produced best-first,
+// heaviest term first, by expanding only the branches that can still beat
+// the completions already emitted.
+class PrefixTrie {
+private:
+    struct Node {
+        string label;          // edge label from the parent
+        uint32_t weight = 0;   // nonzero if a term ends here
+        uint32_t maxWeight = 0;
+        vector<unique_ptr<Node>> children;  // sorted by first label character
+    };
+
+    Node root;
+    size_t termCount;
+
+    static size_t findChild(const Node& node, char first);
+    static void refresh(Node& node);
+
+public:
+    PrefixTrie();
+
+    // Set a term's weight; a weight of zero removes the term
+    void setWeight(const string& term, uint32_t weight);
+    void clear();
+    size_t size() const;
+
+    // Visit the terms starting with `prefix` in descending weight order until
+    // the visitor returns false
+    void visitCompletions(const string& prefix,
+                          const function<bool(const string&, uint32_t)>& visitor) const;
+};
+
+#endif // PREFIX_TRIE_H
@@ -0,0 +1,68 @@
+#ifndef ROLE_POLICY_H
+#define ROLE_POLICY_H
+
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Role identifiers index the policy table. The built-in roles have fixed
+// IDs; roles added with RoleRegistry::registerRole take the next free ID, so
+// a registered role's ID depends on registration order and is only stored
+// on disk together with its name.
+using RoleID = uint8_t;
+
+enum BuiltinRole : RoleID {
+    ROLE_STUDENT = 0,
+    ROLE_FACULTY = 1,
+    ROLE_LIBRARIAN = 2,
+    BUILTIN_ROLE_COUNT = 3
+};
+
+// RolePolicy Structure
+// Everything the library needs to know about a role: what it may do and
+// its borrowing limits.
+struct RolePolicy {
+    const char* name;
+    bool canBorrow;
+    bool canManageBooks;
+    bool canManageUsers;
+    int maxBooks;
+    int maxDays;
+    double fineRate;  // per overdue hour
+};
+
+constexpr RolePolicy BUILTIN_ROLES[BUILTIN_ROLE_COUNT] = {
+    {"Student",   true,  false, false, 3, 15, 10.0},
+    {"Faculty",   true,  true,  false, 5, 30, 0.0},
+    {"Librarian", false, true,  true,  0, 0,  0.0}
+};
+
+static_assert(BUILTIN_ROLES[ROLE_STUDENT].maxBooks == 3, "Student policy out of order");
+static_assert(BUILTIN_ROLES[ROLE_LIBRARIAN].canManageUsers, "Librarian policy out of order");
+
+// RoleRegistry Class
+// Fixed-capacity policy table. Lookups are a plain array index with no
+// locking: a slot is filled before the role count is published, and
+// registered roles are never removed or changed.
+class RoleRegistry {
+public:
+    static const size_t MAX_ROLES = 32;
+    static const RoleID INVALID_ROLE = 0xFF;
+
+    static const RolePolicy& get(RoleID role) { return table[role]; }
+    static bool isValid(RoleID role) { return role < count.load(memory_order_acquire); }
+    static size_t size() { return count.load(memory_order_acquire); }
+    static RoleID find(const string& name);
+    static RoleID registerRole(const RolePolicy& policy);
+
+private:
+    static RolePolicy table[MAX_ROLES];
+    static atomic<size_t> count;
+    static mutex registerMutex;
+};
+
+#endif // ROLE_POLICY_H
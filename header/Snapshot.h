@@ -0,0 +1,102 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Binary snapshot layout (native byte order and alignment; the header
+// records the byte order, and a snapshot from a machine with another one is
+// refused):
+//
+//   SnapshotHeader
+//   SnapshotBook[bookCount]
+//   SnapshotUser[userCount]
+//   SnapshotAccount[accountCount]
+//   SnapshotBorrow[borrowCount]      current borrows then history, per account
+//   SnapshotReservation[reservationCount]
+//   SnapshotTerm[termCount]          search index terms
+//   int32_t[postingCount]            their sorted bookIDs, per term
+//   SnapshotString[roleCount]        role names by the RoleIDs used above
+//   int32_t[changedAccountCount]     accounts not yet written by saveState
+//   string heap                      referenced by SnapshotString
+//
+// Every section is a flat array of fixed-width records, so a mapped snapshot
+// can be walked without tokenizing anything. Each section is zero-padded to
+// a multiple of SNAPSHOT_ALIGNMENT bytes, so every record in a mapped
+// snapshot is suitably aligned.
+
+const char SNAPSHOT_MAGIC[8] = {'L', 'M', 'S', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t SNAPSHOT_VERSION = 6;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+const size_t SNAPSHOT_ALIGNMENT = 8;
+
+struct SnapshotString {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t reserved;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;  // SNAPSHOT_BYTE_ORDER as written by this machine
+    uint64_t bookCount;
+    uint64_t userCount;
+    uint64_t accountCount;
+    uint64_t borrowCount;
+    uint64_t reservationCount;
+    uint64_t termCount;
+    uint64_t postingCount;
+    uint64_t changedAccountCount;
+    uint64_t changedFiles;  // text files not yet rewritten by saveState
+    uint64_t stringHeapSize;
+    uint64_t roleCount;
+};
+
+struct SnapshotBook {
+    int32_t bookID;
+    int32_t year;
+    uint32_t copies;  // availability is rebuilt from the current borrows
+    uint32_t reserved;
+    SnapshotString title;
+    SnapshotString author;
+    SnapshotString publisher;
+    SnapshotString isbn;
+};
+
+struct SnapshotUser {
+    int32_t userID;
+    uint8_t role;  // RoleID, see RolePolicy.h
+    uint8_t reserved[3];
+    SnapshotString name;
+    SnapshotString password;
+    SnapshotString department;
+};
+
+struct SnapshotAccount {
+    int32_t userID;
+    uint32_t currentCount;
+    uint32_t historyCount;
+    uint32_t reserved;
+    double totalFine;
+};
+
+struct SnapshotBorrow {
+    int32_t bookID;
+    uint32_t reserved;
+    int64_t borrowDate;
+    int64_t dueDate;
+};
+
+struct SnapshotReservation {
+    int32_t bookID;
+    int32_t userID;
+};
+
+struct SnapshotTerm {
+    SnapshotString term;
+    uint32_t postingCount;
+    uint32_t reserved;
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,55 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <string>
+#include <string_view>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+using namespace std;
+
+// Compact handle for an interned string; equal strings share one handle
+using StringHandle = uint32_t;
+
+// StringPool Class
+// Stores each distinct value once and hands out integer handles, so
+// repeated fields such as authors, publishers and departments cost four
+// bytes per record and compare as integers. Interned strings are never
+// freed and references to them stay valid for the life of the pool.
+// Handle 0 is always the empty string.
+//
+// get() takes no lock: strings live in chunks that are never moved or
+// freed, chunk k holding FIRST_CHUNK << k of them, and a string is written
+// before its handle is handed out. The lock only guards interning.
+class StringPool {
+private:
+    static const size_t FIRST_CHUNK_BITS = 5;
+    static const size_t FIRST_CHUNK = size_t(1) << FIRST_CHUNK_BITS;
+    static const size_t CHUNK_COUNT = 33 - FIRST_CHUNK_BITS;  // every 32-bit handle
+
+    array<atomic<string*>, CHUNK_COUNT> chunks;
+    atomic<size_t> count;
+    unordered_map<string_view, StringHandle> handles;
+    mutable shared_mutex poolMutex;  // guards handles and appends
+
+    static void locate(StringHandle handle, size_t& chunk, size_t& offset);
+
+public:
+    StringPool();
+    ~StringPool();
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    StringHandle intern(const string& value);
+    bool find(const string& value, StringHandle& handle) const;
+    const string& get(StringHandle handle) const;
+    size_t size() const;
+
+    // Pool shared by every Book and User
+    static StringPool& global();
+};
+
+#endif // STRING_POOL_H
@@ -0,0 +1,28 @@
+#ifndef TEXT_SCAN_H
+#define TEXT_SCAN_H
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// TextScan Class
+// ASCII case-insensitive substring search over one contiguous buffer. On x86
+// builds with GCC or Clang the scan compares the needle's first and last
+// characters against 32 (AVX2, picked at run time) or 16 (SSE2) positions at
+// once and only verifies the candidates those comparisons leave; elsewhere
+// it falls back to a scalar loop.
+class TextScan {
+private:
+    string needle;  // lowercased once, reused by every find
+
+public:
+    explicit TextScan(string_view needle);
+
+    // Position of the first match at or after `from`, or string_view::npos.
+    // An empty needle matches at `from`.
+    size_t find(string_view text, size_t from = 0) const;
+    size_t length() const;
+};
+
+#endif // TEXT_SCAN_H
@@ -0,0 +1,58 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+using namespace std;
+
+// TrigramIndex Class
+// Trigram index over the search vocabulary (the distinct title and author
+// terms), used to find terms within a small edit distance of a misspelt
+// word. Every term is padded as "$$term$$" and split into overlapping
+// three-character grams, so a term of n characters has n + 2 grams. Because
+// one edit changes at most three grams, a term within distance d of a word
+// shares at least (grams - 3d) of its grams; the double padding keeps that
+// above zero for one edit of a three-letter word. Candidates passing that
+// count filter and a length filter are then verified with a bounded
+// edit-distance check. Where the bound drops to zero, every term is checked.
+//
+// The same grams also find the terms that contain a fragment: every gram of
+// the unpadded fragment occurs in such a term, so the terms under the
+// fragment's rarest gram are the only candidates.
+class TrigramIndex {
+private:
+    vector<string> terms;                       // by term ID; empty if freed
+    vector<uint32_t> freeIDs;
+    unordered_map<string, uint32_t> termIDs;
+    unordered_map<uint32_t, vector<uint32_t>> postings;  // gram -> term IDs
+
+    static uint32_t packGram(const char* text);
+    static vector<uint32_t> trigrams(string_view term);
+
+public:
+    struct Match {
+        string term;
+        int distance;
+    };
+
+    void addTerm(const string& term);
+    void removeTerm(const string& term);
+    void clear();
+    size_t size() const;
+
+    // Terms within maxDistance edits of `word`, closest first
+    vector<Match> findSimilar(const string& word, int maxDistance) const;
+
+    // Terms containing `fragment`, which must be at least three characters
+    vector<string> findContaining(string_view fragment) const;
+
+    // Edit distance between a and b, or maxDistance + 1 once it is known to
+    // exceed maxDistance
+    static int boundedEditDistance(string_view a, string_view b, int maxDistance);
+};
+
+#endif // TRIGRAM_INDEX_H
@@ -8,36 +8,10 @@
 #include <functional>
 #include <vector>
 #include "header/LibrarySystem.h"
+#include "header/DataParser.h"
 
 using namespace std;
 
-std::vector<std::string> split(const std::string& str, char delim) {
-    std::vector<std::string> tokens;
-    std::string token;
-    std::istringstream tokenStream(str);
-    while (std::getline(tokenStream, token, delim)) {
-        tokens.push_back(token);
-    }
-    return tokens;
-}
-
-// Function to read data from a file
-void readDataFile(const std::string& filename, std::function<void(const std::vector<std::string>&)> processor) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << std::endl;
-        return;
-    }
-
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') continue;
-        
-        auto parts = split(line, '|');
-        processor(parts);
-    }
-}
-
 // Function declarations
 void clearInputBuffer();
 void waitForEnter();
@@ -59,7 +33,10 @@ void handleReserveBook(Library& library, int userID);
 void handleCancelReservation(Library& library, int userID);
 void handleViewReservations(const Library& library, int userID);
 void handleViewAllBorrowedBooks(const Library& library);
-void initializeLibrary(Library& lib);
+void handleViewOverdueBooks(const Library& library);
+bool executeBatchCommand(Library& library, const DataLine& parts, string& error,
+                         string& output);
+int runBatch(Library& library, istream& input);
 
 void displayMenu() {
     cout << "\n\n";
@@ -106,6 +83,7 @@ void displayUserMenu(const User* user) {
         cout << "14. Remove User\n";
         cout << "15. Check User\n";
         cout << "16. View All Borrowed Books\n";
+        cout << "17. View Overdue Books\n";
     }
     
     cout << "\n0. Logout\n";
@@ -131,18 +109,42 @@ void displayBookDetails(const Book* book) {
     } else {
         cout << "Borrowed";
     }
+    if (book->getCopies() > 1) {
+        cout << " (" << book->getAvailableCopies() << " of " << book->getCopies() << " copies on shelf)";
+    }
     cout << "\n";
 }
 
 void handleSearchBooks(const Library& library) {
     clearInputBuffer();
     string query;
-    cout << "Enter search term (title/author): ";
+    cout << "Enter search term (title/author/ISBN): ";
     getline(cin, query);
 
+    // A scanned or typed ISBN goes straight to its book
+    if (const Book* book = library.getBookByISBN(query)) {
+        displayBookDetails(book);
+        return;
+    }
+
     auto results = library.searchBooks(query);
     if (results.empty()) {
+        auto closeMatches = library.fuzzySearch(query, 10);
+        if (!closeMatches.empty()) {
+            cout << "\nNo exact matches. Showing " << closeMatches.size() << " close matches:\n";
+            for (const auto* book : closeMatches) {
+                displayBookDetails(book);
+            }
+            return;
+        }
         cout << "No books found.\n";
+        auto completions = library.autocomplete(query, 5);
+        if (!completions.empty()) {
+            cout << "Did you mean:\n";
+            for (const auto& completion : completions) {
+                cout << "  " << completion.text << " (" << completion.bookCount << " books)\n";
+            }
+        }
         return;
     }
 
@@ -334,6 +336,7 @@ void handleAddBook(Library& library) {
     int bookID;
     string title, author, publisher, isbn;
     int year;
+    int copies;
 
     cout << "\nAdd New Book\n";
     cout << "Enter Book ID: ";
@@ -356,7 +359,15 @@ void handleAddBook(Library& library) {
     cout << "Enter ISBN: ";
     getline(cin, isbn);
 
-    auto book = std::make_unique<Book>(bookID, title, author, publisher, year, isbn);
+    cout << "Enter Number of Copies: ";
+    while (!(cin >> copies) || copies < Book::MIN_COPIES) {
+        cin.clear();
+        clearInputBuffer();
+        cout << "Invalid number of copies! Enter at least " << Book::MIN_COPIES << ": ";
+    }
+    clearInputBuffer();
+
+    auto book = std::make_unique<Book>(bookID, title, author, publisher, year, isbn, copies);
     if (library.addBook(std::move(book))) {
         cout << "Book added successfully!\n";
     } else {
@@ -455,7 +466,7 @@ void handleCheckUser(const Library& library) {
 void handleViewAllBooks(const Library& library) {
     cout << "\n=== All Books in Library ===\n";
     
-    auto books = library.searchBooks("");  // Empty string to get all books
+    auto books = library.getAllBooks();
     if (books.empty()) {
         cout << "No books in the library.\n";
         return;
@@ -538,32 +549,87 @@ void handleViewReservations(const Library& library, int userID) {
 }
 
 void handleViewAllBorrowedBooks(const Library& library) {
-    auto borrowedBooks = library.getAllBorrowedBooks();
-    if (borrowedBooks.empty()) {
-        cout << "No books are currently borrowed.\n";
-        return;
+    const size_t PAGE_SIZE = 10;
+    LoanQuery query;
+    query.pageSize = PAGE_SIZE;
+
+    clearInputBuffer();
+    cout << "Filter by role (Student/Faculty, blank for all): ";
+    getline(cin, query.role);
+    cout << "Filter by department (blank for all): ";
+    getline(cin, query.department);
+
+    // Loans are fetched one page at a time in due-date order
+    LoanPage page;
+    size_t pageNumber = 0;
+    while (library.getBorrowedBooksPage(query, page)) {
+        if (page.loans.empty()) {
+            if (pageNumber == 0) cout << "No books are currently borrowed.\n";
+            return;
+        }
+
+        cout << "\n=== Currently Borrowed Books (page " << ++pageNumber << ") ===\n\n";
+        for (const auto& info : page.loans) {
+            cout << "Book Details:\n";
+            cout << "-------------\n";
+            displayBookDetails(info.book);
+            cout << "\nBorrower Details:\n";
+            cout << "----------------\n";
+            cout << "ID: " << info.borrower->getUserID() << "\n";
+            cout << "Name: " << info.borrower->getName() << "\n";
+            cout << "Role: " << info.borrower->getRole() << "\n";
+            cout << "Department: " << info.borrower->getDepartment() << "\n";
+
+            // Convert time_points to readable format
+            auto borrowTime = chrono::system_clock::to_time_t(info.borrowDate);
+            auto dueTime = chrono::system_clock::to_time_t(info.dueDate);
+
+            cout << "\nBorrow Date: " << ctime(&borrowTime);
+            cout << "Due Date: " << ctime(&dueTime);
+            cout << "============================\n\n";
+        }
+
+        if (page.nextToken.empty()) return;
+        cout << "Press Enter for the next page or q to stop: ";
+        string answer;
+        if (!getline(cin, answer) || answer == "q" || answer == "Q") return;
+        query.resumeToken = page.nextToken;
     }
+}
 
-    cout << "\n=== Currently Borrowed Books ===\n\n";
-    for (const auto& info : borrowedBooks) {
-        cout << "Book Details:\n";
-        cout << "-------------\n";
-        displayBookDetails(info.book);
-        cout << "\nBorrower Details:\n";
-        cout << "----------------\n";
-        cout << "ID: " << info.borrower->getUserID() << "\n";
-        cout << "Name: " << info.borrower->getName() << "\n";
-        cout << "Role: " << info.borrower->getRole() << "\n";
-        cout << "Department: " << info.borrower->getDepartment() << "\n";
-        
-        // Convert time_points to readable format
-        auto borrowTime = chrono::system_clock::to_time_t(info.borrowDate);
-        auto dueTime = chrono::system_clock::to_time_t(info.dueDate);
-        
-        cout << "\nBorrow Date: " << ctime(&borrowTime);
-        cout << "Due Date: " << ctime(&dueTime);
-        cout << "============================\n\n";
+void handleViewOverdueBooks(const Library& library) {
+    const size_t MAX_LISTED = 20;
+    auto now = chrono::system_clock::now();
+    size_t overdueCount = 0;
+    double accruedFines = 0.0;
+
+    // One pass over the overdue part of the due-date index: list the most
+    // overdue loans and total the fines accrued so far across all of them
+    cout << "\n=== Overdue Books (most overdue first) ===\n\n";
+    library.forEachOverdue(now, [&](const BorrowInfo& info) {
+        auto overdueHours = chrono::duration_cast<chrono::hours>(now - info.dueDate).count();
+        double fine = overdueHours * info.borrower->getFineRate();
+        accruedFines += fine;
+        if (++overdueCount <= MAX_LISTED) {
+            auto dueTime = chrono::system_clock::to_time_t(info.dueDate);
+            cout << "Book " << info.book->getBookID() << ": " << info.book->getTitle() << "\n";
+            cout << "Borrower: " << info.borrower->getUserID() << " (" << info.borrower->getName() << ")\n";
+            cout << "Due Date: " << ctime(&dueTime);
+            cout << "Overdue: " << overdueHours / 24 << " days, fine so far: Rs. " << fixed << setprecision(2) << fine << "\n";
+            cout << "----------------------------\n";
+        }
+        return true;
+    });
+
+    if (overdueCount == 0) {
+        cout << "No books are overdue.\n";
+        return;
+    }
+    if (overdueCount > MAX_LISTED) {
+        cout << "... and " << overdueCount - MAX_LISTED << " more\n";
     }
+    cout << "Total overdue loans: " << overdueCount << "\n";
+    cout << "Total fines accrued: Rs. " << fixed << setprecision(2) << accruedFines << "\n";
 }
 
 // Add these function definitions right after your includes and before other functions
@@ -578,59 +644,210 @@ void waitForEnter() {
     cin.get();
 }
 
-// Function to initialize the library with data from files
-void initializeLibrary(Library& lib) {
-    // Read books
-    readDataFile("data/books.txt", [&lib](const auto& parts) {
-        if (parts.size() == 7) {  
-            int id = std::stoi(parts[0]);
-            int year = std::stoi(parts[4]);
-            bool available = parts[6] == "1";
-            auto book = std::make_unique<Book>(
-                id, parts[1], parts[2], parts[3], year, parts[5]
-            );
-            book->setAvailable(available);  // Set the availability status
-            lib.addBook(std::move(book));
+// Batch mode: one pipe-delimited command per line, no prompts.
+//
+//   borrow|userID|bookID          return|userID|bookID
+//   reserve|userID|bookID         cancel|userID|bookID
+//   pay|userID|amount
+//   add-book|bookID|title|author|publisher|year|ISBN[|copies]
+//   copies|bookID|copies
+//   add-user|S/F/L or role name|userID|name|password|department
+//   add-role|name|canBorrow|canManageBooks|canManageUsers|maxBooks|maxDays|fineRate
+//   complete|prefix|limit         fuzzy|query|limit
+//   isbn|ISBN                     sync
+//
+// Blank lines and lines starting with '#' are skipped; every other line
+// produces one result line on stdout:
+//
+//   lineNumber|OK|command
+//   lineNumber|OK|command|result...      queries append their results
+//   lineNumber|FAIL|command              the library rejected the operation
+//   lineNumber|ERROR|command|message     the line could not be parsed
+bool executeBatchCommand(Library& library, const DataLine& parts, string& error,
+                         string& output) {
+    string_view command = parts[0];
+    auto expectFields = [&](size_t count) {
+        if (parts.size() != count) {
+            error = "expected " + to_string(count - 1) + " fields";
+            return false;
         }
-    });
-
-    // Read students
-    readDataFile("data/students.txt", [&lib](const auto& parts) {
-        if (parts.size() == 4) {
-            int id = std::stoi(parts[0]);
-            auto student = std::make_unique<Student>(id, parts[1], parts[2]);
-            student->setDepartment(parts[3]);
-            lib.addUser(std::move(student));
-            lib.loadAccountInfo(id);  // Load account information
+        return true;
+    };
+    auto invalidNumber = [&]() {
+        error = "invalid number";
+        return false;
+    };
+
+    if (command == "borrow" || command == "return" ||
+        command == "reserve" || command == "cancel") {
+        if (!expectFields(3)) return false;
+        int userID;
+        int bookID;
+        if (!parts.getInt(1, userID) || !parts.getInt(2, bookID)) return invalidNumber();
+        if (command == "borrow") return library.borrowBook(userID, bookID);
+        if (command == "return") return library.returnBook(userID, bookID);
+        if (command == "reserve") return library.reserveBook(userID, bookID);
+        return library.cancelReservation(userID, bookID);
+    }
+    if (command == "pay") {
+        if (!expectFields(3)) return false;
+        int userID;
+        double amount;
+        if (!parts.getInt(1, userID) || !parts.getDouble(2, amount)) return invalidNumber();
+        return library.payFine(userID, amount);
+    }
+    if (command == "add-book") {
+        if (parts.size() != 8 && !expectFields(7)) return false;
+        int bookID;
+        int year;
+        int copies = 1;
+        if (!parts.getInt(1, bookID) || !parts.getInt(5, year) ||
+            (parts.size() == 8 && !parts.getInt(7, copies))) {
+            return invalidNumber();
         }
-    });
-
-    // Read faculty
-    readDataFile("data/faculty.txt", [&lib](const auto& parts) {
-        if (parts.size() == 4) {
-            int id = std::stoi(parts[0]);
-            auto faculty = std::make_unique<Faculty>(id, parts[1], parts[2]);
-            faculty->setDepartment(parts[3]);
-            lib.addUser(std::move(faculty));
-            lib.loadAccountInfo(id);  // Load account information
+        return library.addBook(std::make_unique<Book>(
+            bookID, parts.str(2), parts.str(3), parts.str(4), year, parts.str(6), copies));
+    }
+    if (command == "copies") {
+        if (!expectFields(3)) return false;
+        int bookID;
+        int copies;
+        if (!parts.getInt(1, bookID) || !parts.getInt(2, copies)) return invalidNumber();
+        return library.setCopies(bookID, copies);
+    }
+    if (command == "add-user") {
+        if (!expectFields(6)) return false;
+        int userID;
+        if (!parts.getInt(2, userID)) return invalidNumber();
+        RoleID role = RoleRegistry::find(parts.str(1));
+        if (role == RoleRegistry::INVALID_ROLE && parts[1].size() == 1) {
+            switch (std::toupper(parts[1][0])) {
+                case 'S': role = ROLE_STUDENT; break;
+                case 'F': role = ROLE_FACULTY; break;
+                case 'L': role = ROLE_LIBRARIAN; break;
+            }
         }
-    });
-
-    // Read librarians
-    readDataFile("data/librarians.txt", [&lib](const auto& parts) {
-        if (parts.size() == 4) {
-            int id = std::stoi(parts[0]);
-            auto librarian = std::make_unique<Librarian>(id, parts[1], parts[2]);
-            librarian->setDepartment(parts[3]);
-            lib.addUser(std::move(librarian));
-            lib.loadAccountInfo(id);  // Load account information
+        if (role == RoleRegistry::INVALID_ROLE) {
+            error = "invalid user type";
+            return false;
         }
-    });
+        auto user = std::make_unique<User>(userID, parts.str(3), parts.str(4), role);
+        user->setDepartment(parts.str(5));
+        return library.addUser(std::move(user));
+    }
+    if (command == "add-role") {
+        if (!expectFields(8)) return false;
+        int maxBooks;
+        int maxDays;
+        double fineRate;
+        if (!parts.getInt(5, maxBooks) || !parts.getInt(6, maxDays) ||
+            !parts.getDouble(7, fineRate)) {
+            return invalidNumber();
+        }
+        string name = parts.str(1);
+        RolePolicy policy{name.c_str(), parts[2] == "1", parts[3] == "1", parts[4] == "1",
+                          maxBooks, maxDays, fineRate};
+        return library.registerRole(policy) != RoleRegistry::INVALID_ROLE;
+    }
+
+    if (command == "complete") {
+        // One result field per completion: text:bookCount:space-separated bookIDs
+        if (!expectFields(3)) return false;
+        int limit;
+        if (!parts.getInt(2, limit) || limit < 0) return invalidNumber();
+        for (const auto& completion : library.autocomplete(parts.str(1), limit)) {
+            output += "|" + completion.text + ":" + to_string(completion.bookCount) + ":";
+            for (size_t i = 0; i < completion.bookIDs.size(); ++i) {
+                output += (i ? " " : "") + to_string(completion.bookIDs[i]);
+            }
+        }
+        return true;
+    }
+    if (command == "isbn") {
+        if (!expectFields(2)) return false;
+        const Book* book = library.getBookByISBN(parts.str(1));
+        if (!book) return false;
+        output = "|" + to_string(book->getBookID());
+        return true;
+    }
+    if (command == "sync") {
+        // Wait for the journal writer; the result is the durable sequence
+        if (!expectFields(1)) return false;
+        if (!library.waitDurable(library.getLastSequence())) return false;
+        output = "|" + to_string(library.getDurableSequence());
+        return true;
+    }
+    if (command == "fuzzy") {
+        // One result field per matching bookID, closest first
+        if (!expectFields(3)) return false;
+        int limit;
+        if (!parts.getInt(2, limit) || limit < 0) return invalidNumber();
+        for (const auto* book : library.fuzzySearch(parts.str(1), limit)) {
+            output += "|" + to_string(book->getBookID());
+        }
+        return true;
+    }
+
+    error = "unknown command";
+    return false;
 }
 
-int main() {
+// Lines are read one at a time so results stream back as commands arrive;
+// each line goes through the same DataParser as the data files, which trims
+// it and skips blank and '#' comment lines.
+int runBatch(Library& library, istream& input) {
+    ios::sync_with_stdio(false);
+
+    DataParser parser("batch input");
+    string line;
+    size_t lineNumber = 0;
+    size_t failures = 0;
+    while (getline(input, line)) {
+        ++lineNumber;
+        parser.parseText(line, [&](const DataLine& parts) {
+            string error;
+            string output;
+            bool ok = executeBatchCommand(library, parts, error, output);
+
+            cout << lineNumber << (ok ? "|OK|" : error.empty() ? "|FAIL|" : "|ERROR|") << parts[0];
+            if (!error.empty()) cout << "|" << error;
+            if (ok) cout << output;
+            cout << '\n';
+            if (!ok) ++failures;
+            return true;  // reported on stdout, not as a malformed record
+        });
+    }
+
+    library.checkpoint();
+    cout.flush();
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
     Library library;
-    initializeLibrary(library);
+
+    // Batch mode: main --batch [file], reading stdin when no file is given
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        // Keep stdout machine-readable: progress messages go to stderr
+        streambuf* stdoutBuffer = cout.rdbuf(cerr.rdbuf());
+        bool loaded = library.loadState();
+        cout.rdbuf(stdoutBuffer);
+        if (!loaded) return 2;
+
+        if (argc > 2 && string(argv[2]) != "-") {
+            ifstream input(argv[2]);
+            if (!input.is_open()) {
+                cerr << "Error: Could not open batch file " << argv[2] << endl;
+                return 2;
+            }
+            return runBatch(library, input);
+        }
+        return runBatch(library, cin);
+    }
+
+    if (!library.loadState()) {
+        return 1;
+    }
 
     while (true) {
         displayMenu();
@@ -638,7 +855,8 @@ int main() {
         cin >> choice;
 
         if (choice == 2) {
-            library.saveState();  // Save before exiting
+            library.checkpoint();  // Fold the journal into a snapshot before exiting
+            library.saveState();   // Keep the text data files current as an export
             cout << "Thank you for using the Library Management System!\n";
             waitForEnter();
             break;
@@ -661,7 +879,6 @@ int main() {
                         cin >> userChoice;
 
                         if (userChoice == 0) {
-                            library.saveState();  // Save before logging out
                             cout << "Logging out...\n";
                             waitForEnter();
                             break;
@@ -679,28 +896,24 @@ int main() {
                             case 3:
                                 if (user->canBorrow()) {
                                     handleBorrowBook(library, userID);
-                                    library.saveState();
                                     waitForEnter();
                                 }
                                 break;
                             case 4:
                                 if (user->canBorrow()) {
                                     handleReturnBook(library, userID);
-                                    library.saveState();
                                     waitForEnter();
                                 }
                                 break;
                             case 5:
                                 if (user->canBorrow()) {
                                     handleReserveBook(library, userID);
-                                    library.saveState();
                                     waitForEnter();
                                 }
                                 break;
                             case 6:
                                 if (user->canBorrow()) {
                                     handleCancelReservation(library, userID);
-                                    library.saveState();
                                     waitForEnter();
                                 }
                                 break;
@@ -725,35 +938,30 @@ int main() {
                             case 10:
                                 if (user->canBorrow()) {
                                     handlePayFine(library, userID);
-                                    library.saveState();
                                     waitForEnter();
                                 }
                                 break;
                             case 11:
                                 if (user->canManageBooks()) {
                                     handleAddBook(library);
-                                    library.saveState();
                                     waitForEnter();
                                 }
                                 break;
                             case 12:
                                 if (user->canManageBooks()) {
                                     handleRemoveBook(library);
-                                    library.saveState();
                                     waitForEnter();
                                 }
                                 break;
                             case 13:
                                 if (user->canManageUsers()) {
                                     handleAddUser(library);
-                                    library.saveState();
                                     waitForEnter();
                                 }
                                 break;
                             case 14:
                                 if (user->canManageUsers()) {
                                     handleRemoveUser(library);
-                                    library.saveState();
                                     waitForEnter();
                                 }
                                 break;
@@ -769,6 +977,12 @@ int main() {
                                     waitForEnter();
                                 }
                                 break;
+                            case 17:
+                                if (user->canManageUsers()) {
+                                    handleViewOverdueBooks(library);
+                                    waitForEnter();
+                                }
+                                break;
                             default: 
                                 cout << "Invalid choice!\n";
                                 waitForEnter();
@@ -0,0 +1,248 @@
+#include "../header/AccountStore.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+using namespace std;
+
+static const char STORE_MAGIC[8] = {'L', 'M', 'S', 'A', 'C', 'C', 'T', '\0'};
+static const uint32_t STORE_VERSION = 1;
+static const uint64_t STORE_HEADER_SIZE = sizeof(STORE_MAGIC) + 2 * sizeof(uint32_t);
+
+static bool writeStoreHeader(ostream& out) {
+    uint32_t fields[2] = {STORE_VERSION, 0};
+    out.write(STORE_MAGIC, sizeof(STORE_MAGIC));
+    out.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+    return out.good();
+}
+
+// AccountStore Implementation
+const uint32_t AccountStore::SEGMENT_LIVE;
+const uint32_t AccountStore::MIN_CAPACITY;
+
+AccountStore::AccountStore(const string& path)
+    : path(path), fileSize(0), liveBytes(0) {}
+
+// Open (creating if needed) the store and rebuild the offset index from the
+// segment headers. Opening an already open store is a no-op.
+bool AccountStore::open() {
+    if (file.is_open()) return true;
+    index.clear();
+    fileSize = 0;
+    liveBytes = 0;
+
+    file.open(path, ios::in | ios::out | ios::binary);
+    if (!file.is_open()) {
+        ofstream create(path, ios::binary | ios::trunc);
+        if (!create.is_open() || !writeStoreHeader(create)) {
+            cerr << "Error: Could not create account store: " << path << endl;
+            return false;
+        }
+        create.close();
+        file.open(path, ios::in | ios::out | ios::binary);
+        if (!file.is_open()) {
+            cerr << "Error: Could not open account store: " << path << endl;
+            return false;
+        }
+    }
+
+    file.seekg(0, ios::end);
+    uint64_t size = static_cast<uint64_t>(file.tellg());
+    char magic[sizeof(STORE_MAGIC)];
+    uint32_t fields[2];
+    file.seekg(0);
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(fields), sizeof(fields));
+    if (!file || memcmp(magic, STORE_MAGIC, sizeof(magic)) != 0 || fields[0] != STORE_VERSION) {
+        cerr << "Error: Unsupported account store format: " << path << endl;
+        file.close();
+        return false;
+    }
+
+    // Walk the segment headers; a torn segment at the tail is ignored and
+    // overwritten by the next append
+    uint64_t offset = STORE_HEADER_SIZE;
+    Segment segment;
+    while (offset + sizeof(Segment) <= size) {
+        file.seekg(offset);
+        file.read(reinterpret_cast<char*>(&segment), sizeof(segment));
+        uint64_t next = offset + sizeof(Segment) + segment.capacity;
+        if (!file || next > size || segment.length > segment.capacity) break;
+
+        if (segment.flags & SEGMENT_LIVE) {
+            auto it = index.find(segment.userID);
+            if (it != index.end()) {
+                liveBytes -= sizeof(Segment) + it->second.capacity;
+            }
+            index[segment.userID] = {offset, segment.capacity};
+            liveBytes += sizeof(Segment) + segment.capacity;
+        }
+        offset = next;
+    }
+    file.clear();
+    fileSize = offset;
+    return true;
+}
+
+bool AccountStore::isOpen() const { return file.is_open(); }
+
+void AccountStore::close() {
+    if (file.is_open()) file.close();
+    index.clear();
+}
+
+bool AccountStore::contains(int userID) const {
+    return index.find(userID) != index.end();
+}
+
+bool AccountStore::read(int userID, string& payload) {
+    if (!open()) return false;
+    auto it = index.find(userID);
+    if (it == index.end()) return false;
+
+    Segment segment;
+    file.clear();
+    file.seekg(it->second.offset);
+    file.read(reinterpret_cast<char*>(&segment), sizeof(segment));
+    payload.resize(segment.length);
+    file.read(&payload[0], segment.length);
+    return static_cast<bool>(file);
+}
+
+bool AccountStore::writeSegment(uint64_t offset, const Segment& segment, const string& payload) {
+    file.clear();
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char*>(&segment), sizeof(segment));
+    file.write(payload.data(), payload.size());
+    return static_cast<bool>(file);
+}
+
+bool AccountStore::markFree(uint64_t offset) {
+    uint32_t flags = 0;
+    file.clear();
+    file.seekp(offset + offsetof(Segment, flags));
+    file.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+    return static_cast<bool>(file);
+}
+
+// Overwrite the user's segment in place when the payload fits; otherwise
+// append a segment with room to grow and free the old one
+bool AccountStore::write(int userID, const string& payload) {
+    if (!open()) return false;
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    auto it = index.find(userID);
+
+    if (it != index.end() && length <= it->second.capacity) {
+        Segment segment{userID, SEGMENT_LIVE, it->second.capacity, length};
+        bool ok = writeSegment(it->second.offset, segment, payload);
+        file.flush();
+        return ok;
+    }
+
+    uint32_t capacity = max(MIN_CAPACITY, length * 2);
+    Segment segment{userID, SEGMENT_LIVE, capacity, length};
+    uint64_t offset = fileSize;
+    string padded = payload;
+    padded.resize(capacity, '\0');
+    if (!writeSegment(offset, segment, padded)) {
+        cerr << "Error: Could not write account " << userID << " to " << path << endl;
+        return false;
+    }
+    fileSize += sizeof(Segment) + capacity;
+    liveBytes += sizeof(Segment) + capacity;
+
+    if (it != index.end()) {
+        markFree(it->second.offset);
+        liveBytes -= sizeof(Segment) + it->second.capacity;
+        it->second = {offset, capacity};
+    } else {
+        index[userID] = {offset, capacity};
+    }
+    file.flush();
+    return true;
+}
+
+bool AccountStore::remove(int userID) {
+    if (!open()) return false;
+    auto it = index.find(userID);
+    if (it == index.end()) return false;
+    markFree(it->second.offset);
+    liveBytes -= sizeof(Segment) + it->second.capacity;
+    index.erase(it);
+    file.flush();
+    return true;
+}
+
+// Read every live account payload in one sequential pass over the file
+unordered_map<int, string> AccountStore::readAll() {
+    unordered_map<int, string> payloads;
+    if (!open()) return payloads;
+
+    vector<char> buffer(fileSize);
+    file.clear();
+    file.seekg(0);
+    file.read(buffer.data(), buffer.size());
+    if (!file) return payloads;
+
+    payloads.reserve(index.size());
+    for (const auto& pair : index) {
+        Segment segment;
+        memcpy(&segment, buffer.data() + pair.second.offset, sizeof(segment));
+        payloads[pair.first].assign(buffer.data() + pair.second.offset + sizeof(Segment),
+                                    segment.length);
+    }
+    return payloads;
+}
+
+vector<int> AccountStore::getUserIDs() const {
+    vector<int> userIDs;
+    userIDs.reserve(index.size());
+    for (const auto& pair : index) {
+        userIDs.push_back(pair.first);
+    }
+    return userIDs;
+}
+
+// Compact once more than half of the segment space is free
+bool AccountStore::needsCompaction() const {
+    uint64_t segmentBytes = fileSize > STORE_HEADER_SIZE ? fileSize - STORE_HEADER_SIZE : 0;
+    return segmentBytes > 4096 && liveBytes * 2 < segmentBytes;
+}
+
+// Rewrite the store with only its live segments
+bool AccountStore::compact() {
+    auto payloads = readAll();
+    string tempPath = path + ".tmp";
+    ofstream out(tempPath, ios::binary | ios::trunc);
+    if (!out.is_open() || !writeStoreHeader(out)) {
+        cerr << "Error: Could not compact account store: " << path << endl;
+        return false;
+    }
+
+    for (const auto& pair : payloads) {
+        uint32_t length = static_cast<uint32_t>(pair.second.size());
+        Segment segment{pair.first, SEGMENT_LIVE, max(MIN_CAPACITY, length * 2), length};
+        string padded = pair.second;
+        padded.resize(segment.capacity, '\0');
+        out.write(reinterpret_cast<const char*>(&segment), sizeof(segment));
+        out.write(padded.data(), padded.size());
+    }
+    out.close();
+    if (out.fail()) {
+        cerr << "Error: Could not compact account store: " << path << endl;
+        return false;
+    }
+
+    close();
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (rename(tempPath.c_str(), path.c_str()) != 0) {
+        cerr << "Error: Could not replace account store: " << path << endl;
+    }
+    return open();
+}
+
+const string& AccountStore::getPath() const { return path; }
@@ -0,0 +1,187 @@
+#include "../header/BookColumns.h"
+#include "../header/LibrarySystem.h"
+#include <cctype>
+#include <thread>
+
+using namespace std;
+
+// BookColumns Implementation
+const size_t BookColumns::NO_ROW;
+
+BookColumns::BookColumns() : liveCount(0) {}
+
+void BookColumns::setBit(size_t row, bool value) {
+    uint64_t mask = uint64_t(1) << (row % BITS_PER_WORD);
+    if (value) {
+        availableBits[row / BITS_PER_WORD].fetch_or(mask, memory_order_relaxed);
+    } else {
+        availableBits[row / BITS_PER_WORD].fetch_and(~mask, memory_order_relaxed);
+    }
+}
+
+void BookColumns::append(const Book& book) {
+    size_t row = rows.size();
+    if (row % BITS_PER_WORD == 0) {
+        liveBits.push_back(0);
+        availableBits.emplace_back(0);
+    }
+
+    ids.push_back(book.getBookID());
+    years.push_back(book.getYear());
+    authors.push_back(book.getAuthorHandle());
+    publishers.push_back(book.getPublisherHandle());
+    rows.push_back(&book);
+    liveBits[row / BITS_PER_WORD] |= uint64_t(1) << (row % BITS_PER_WORD);
+    setBit(row, book.isAvailable());
+
+    // Searchable text: lowercased title and author, separated by a newline
+    textOffsets.push_back(arena.size());
+    for (char c : book.getTitle()) arena += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    arena += '\n';
+    for (char c : book.getAuthor()) arena += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    textLengths.push_back(arena.size() - textOffsets.back());
+
+    rowOf[book.getBookID()] = row;
+    ++liveCount;
+}
+
+bool BookColumns::erase(int bookID) {
+    auto it = rowOf.find(bookID);
+    if (it == rowOf.end()) return false;
+    size_t row = it->second;
+    liveBits[row / BITS_PER_WORD] &= ~(uint64_t(1) << (row % BITS_PER_WORD));
+    setBit(row, false);
+    rows[row] = nullptr;
+    rowOf.erase(it);
+    --liveCount;
+
+    if (rows.size() > 64 && liveCount * 2 < rows.size()) {
+        compact();
+    }
+    return true;
+}
+
+void BookColumns::setAvailable(int bookID, bool available) {
+    auto it = rowOf.find(bookID);
+    if (it != rowOf.end()) {
+        setBit(it->second, available);
+    }
+}
+
+void BookColumns::clear() {
+    ids.clear();
+    years.clear();
+    authors.clear();
+    publishers.clear();
+    textOffsets.clear();
+    textLengths.clear();
+    rows.clear();
+    liveBits.clear();
+    availableBits.clear();
+    arena.clear();
+    rowOf.clear();
+    liveCount = 0;
+}
+
+// Drop tombstoned rows and their arena text, keeping insertion order
+void BookColumns::compact() {
+    vector<const Book*> liveRows;
+    liveRows.reserve(liveCount);
+    for (size_t row = 0; row < rows.size(); ++row) {
+        if (isLive(row)) liveRows.push_back(rows[row]);
+    }
+    clear();
+    for (const Book* book : liveRows) {
+        append(*book);
+    }
+}
+
+size_t BookColumns::rowCount() const { return rows.size(); }
+size_t BookColumns::size() const { return liveCount; }
+
+bool BookColumns::isLive(size_t row) const {
+    return (liveBits[row / BITS_PER_WORD] >> (row % BITS_PER_WORD)) & 1;
+}
+
+bool BookColumns::isAvailable(size_t row) const {
+    return (availableBits[row / BITS_PER_WORD].load(memory_order_relaxed) >> (row % BITS_PER_WORD)) & 1;
+}
+
+int BookColumns::getBookID(size_t row) const { return ids[row]; }
+int BookColumns::getYear(size_t row) const { return years[row]; }
+StringHandle BookColumns::getAuthorHandle(size_t row) const { return authors[row]; }
+StringHandle BookColumns::getPublisherHandle(size_t row) const { return publishers[row]; }
+const Book* BookColumns::getBook(size_t row) const { return rows[row]; }
+
+string_view BookColumns::getSearchText(size_t row) const {
+    return string_view(arena.data() + textOffsets[row], textLengths[row]);
+}
+
+const string& BookColumns::getArena() const { return arena; }
+size_t BookColumns::getTextOffset(size_t row) const { return textOffsets[row]; }
+
+size_t BookColumns::findRow(int bookID) const {
+    auto it = rowOf.find(bookID);
+    return it == rowOf.end() ? NO_ROW : it->second;
+}
+
+// Run the kernel over the arena text of rows [begin, end). Rows are stored
+// back to back, so after each hit the row containing it is found by walking
+// forward; hits that run into the next row are discarded and the scan
+// resumes after the end of every matching row.
+void BookColumns::scanRows(const TextScan& scan, size_t begin, size_t end,
+                           vector<const Book*>& matches) const {
+    if (begin >= end) return;
+    string_view text(arena.data(), textOffsets[end - 1] + textLengths[end - 1]);
+    size_t row = begin;
+    size_t pos = textOffsets[begin];
+    while ((pos = scan.find(text, pos)) != string_view::npos) {
+        while (pos >= textOffsets[row] + textLengths[row]) ++row;
+        size_t rowEnd = textOffsets[row] + textLengths[row];
+        if (pos + scan.length() <= rowEnd) {
+            if (isLive(row)) matches.push_back(rows[row]);
+            pos = rowEnd;
+        } else {
+            ++pos;
+        }
+    }
+}
+
+vector<const Book*> BookColumns::findText(string_view needle) const {
+    vector<const Book*> matches;
+    TextScan scan(needle);
+    if (needle.empty()) {
+        for (size_t row = 0; row < rows.size(); ++row) {
+            if (isLive(row)) matches.push_back(rows[row]);
+        }
+        return matches;
+    }
+
+    size_t threadCount = 1;
+    if (arena.size() >= PARALLEL_SCAN_BYTES) {
+        threadCount = min<size_t>(max(1u, thread::hardware_concurrency()), rows.size());
+    }
+    if (threadCount <= 1) {
+        scanRows(scan, 0, rows.size(), matches);
+        return matches;
+    }
+
+    // One contiguous shard of rows per thread; concatenating the shards in
+    // order keeps the results in insertion order
+    size_t shardSize = (rows.size() + threadCount - 1) / threadCount;
+    vector<vector<const Book*>> shards(threadCount);
+    vector<thread> workers;
+    for (size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back([this, &scan, &shards, t, shardSize] {
+            size_t begin = t * shardSize;
+            scanRows(scan, begin, min(begin + shardSize, rows.size()), shards[t]);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& shard : shards) {
+        matches.insert(matches.end(), shard.begin(), shard.end());
+    }
+    return matches;
+}
@@ -0,0 +1,59 @@
+#include "../header/DataParser.h"
+#include <charconv>
+#include <iostream>
+
+using namespace std;
+
+// Parse the whole field as a number, rejecting empty fields and trailing junk
+template<typename T>
+static bool parseNumber(string_view field, T& value) {
+    if (field.empty()) return false;
+    auto result = from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == errc() && result.ptr == field.data() + field.size();
+}
+
+// DataLine Implementation
+bool DataLine::getInt(size_t index, int& value) const {
+    return index < fields.size() && parseNumber(fields[index], value);
+}
+
+bool DataLine::getInt64(size_t index, int64_t& value) const {
+    return index < fields.size() && parseNumber(fields[index], value);
+}
+
+bool DataLine::getDouble(size_t index, double& value) const {
+    return index < fields.size() && parseNumber(fields[index], value);
+}
+
+// DataParser Implementation
+const size_t DataParser::CHUNK_SIZE;
+const size_t DataParser::MAX_REPORTED_ERRORS;
+
+DataParser::DataParser(const string& source, char delimiter)
+    : source(source), delimiter(delimiter), lineNumber(0), recordCount(0), errorCount(0) {}
+
+void DataParser::reportError() {
+    if (++errorCount <= MAX_REPORTED_ERRORS) {
+        cerr << "Error: " << source << ":" << lineNumber << ": malformed record" << endl;
+    }
+}
+
+void DataParser::finish() {
+    if (errorCount > MAX_REPORTED_ERRORS) {
+        cerr << "Error: " << source << ": " << errorCount << " malformed records in total" << endl;
+    }
+}
+
+void DataParser::split(string_view text, char delimiter, vector<string_view>& fields) {
+    fields.clear();
+    size_t start = 0;
+    while (true) {
+        size_t end = text.find(delimiter, start);
+        if (end == string_view::npos) {
+            fields.push_back(text.substr(start));
+            return;
+        }
+        fields.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+}
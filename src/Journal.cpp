@@ -0,0 +1,345 @@
+#include "../header/Journal.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Journal Implementation
+const char* const Journal::TORN_MARKER = "<torn>";
+
+Journal::Journal(const string& path)
+    : path(path), file(nullptr), recordCount(0), flushInterval(10),
+      syncPolicy(JournalSync::NONE), lastSequence(0), baseSequence(0), durableSequence(0),
+      flushRequested(false), stopping(false), writeFailed(false) {}
+
+Journal::~Journal() {
+    close();
+}
+
+// Flush a stdio file and push it through to the disk
+bool Journal::syncFile(FILE* file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Make a rename into the directory holding `path` durable. Windows cannot
+// open a directory for syncing; NTFS journals the rename itself.
+bool Journal::syncDirectory(const string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    string directory = filesystem::path(path).parent_path().string();
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#endif
+}
+
+// Takes effect from the writer's next batch
+void Journal::configure(chrono::milliseconds interval, JournalSync policy) {
+    lock_guard<mutex> queueLock(queueMutex);
+    flushInterval = interval;
+    syncPolicy = policy;
+}
+
+// Cut a record left half-written by a crash off the end of the journal, so
+// it is neither replayed nor joined to the next record appended, and return
+// the number of complete records. Call before replaying.
+size_t Journal::recover() {
+    ifstream existing(path, ios::binary);
+    if (!existing.is_open()) return 0;
+    string contents((istreambuf_iterator<char>(existing)), istreambuf_iterator<char>());
+    existing.close();
+
+    size_t complete = contents.rfind('\n');
+    complete = complete == string::npos ? 0 : complete + 1;
+    size_t records = static_cast<size_t>(count(contents.begin(), contents.begin() + complete, '\n'));
+    if (complete < contents.size()) {
+        error_code error;
+        filesystem::resize_file(path, complete, error);
+        if (!error) {
+            cerr << "Discarded incomplete record at the end of " << path << endl;
+        } else {
+            // Terminate it with a marker instead; replay skips marked records
+            FILE* tail = fopen(path.c_str(), "a");
+            string marker = string("|") + TORN_MARKER + "\n";
+            if (!tail || fputs(marker.c_str(), tail) == EOF) {
+                cerr << "Error: Could not repair incomplete journal record: " << path << endl;
+            } else {
+                ++records;
+            }
+            if (tail) fclose(tail);
+        }
+    }
+    return records;
+}
+
+// Open the journal for appending and start the writer. Records already on
+// disk (replayed by the caller) are numbered as if just appended and still
+// count towards the next checkpoint.
+bool Journal::open(size_t existingRecords) {
+    close();
+    FILE* opened = fopen(path.c_str(), "a");
+    if (!opened) {
+        cerr << "Error: Could not open journal for writing: " << path << endl;
+        return false;
+    }
+    {
+        lock_guard<mutex> fileLock(fileMutex);
+        lock_guard<mutex> queueLock(queueMutex);
+        file = opened;
+        recordCount = existingRecords;
+        baseSequence = lastSequence;
+        lastSequence += existingRecords;
+        durableSequence = lastSequence;
+        stopping = false;
+    }
+    writer = thread(&Journal::writerLoop, this);
+    return true;
+}
+
+// Write out everything still queued, stop the writer and close the file
+void Journal::close() {
+    if (!writer.joinable()) return;
+    {
+        lock_guard<mutex> queueLock(queueMutex);
+        stopping = true;
+    }
+    writerWake.notify_one();
+    writer.join();
+
+    lock_guard<mutex> fileLock(fileMutex);
+    lock_guard<mutex> queueLock(queueMutex);
+    if (file) fclose(file);
+    file = nullptr;
+    durableAdvanced.notify_all();
+}
+
+bool Journal::isOpen() const {
+    lock_guard<mutex> queueLock(queueMutex);
+    return file != nullptr && !stopping;
+}
+
+// Queue one record and return its sequence number, or 0 if the journal is
+// closed and the record was dropped
+uint64_t Journal::append(const string& record) {
+    bool wakeWriter;
+    uint64_t sequence;
+    {
+        lock_guard<mutex> queueLock(queueMutex);
+        if (!file || stopping) return 0;
+        wakeWriter = pending.empty();
+        pending += record;
+        pending += '\n';
+        sequence = ++lastSequence;
+        ++recordCount;
+        wakeWriter = wakeWriter || pending.size() >= MAX_PENDING_BYTES;
+    }
+    if (wakeWriter) writerWake.notify_one();
+    return sequence;
+}
+
+// Block until every record up to `sequence` has been written. Returns false
+// if the journal closed first.
+bool Journal::waitDurable(uint64_t sequence) {
+    unique_lock<mutex> queueLock(queueMutex);
+    if (durableSequence.load() >= sequence) return true;
+    flushRequested = true;
+    writerWake.notify_one();
+    durableAdvanced.wait(queueLock, [&] { return durableSequence.load() >= sequence || !file; });
+    return durableSequence.load() >= sequence;
+}
+
+// The file lock is taken before a batch is dequeued, so truncateThrough()
+// either finds the batch still queued or already written, never in between.
+void Journal::writerLoop() {
+    string batch;
+    while (true) {
+        {
+            // Sleep until there is something to write, then give later
+            // records one flush interval to join the batch
+            unique_lock<mutex> queueLock(queueMutex);
+            writerWake.wait(queueLock, [&] { return stopping || flushRequested || !pending.empty(); });
+            writerWake.wait_for(queueLock, flushInterval, [&] {
+                return stopping || flushRequested || pending.size() >= MAX_PENDING_BYTES;
+            });
+        }
+
+        lock_guard<mutex> fileLock(fileMutex);
+        uint64_t batchEnd;
+        bool stop;
+        JournalSync policy;
+        {
+            lock_guard<mutex> queueLock(queueMutex);
+            batch.swap(pending);
+            pending.clear();
+            batchEnd = lastSequence;
+            stop = stopping;
+            policy = syncPolicy;
+            flushRequested = false;
+        }
+
+        // A failed batch goes back to the front of the queue and is retried
+        // with the next one; it only counts as durable once it is written
+        bool written = batch.empty();
+        if (!written && file) written = writeBatch(batch, policy);
+        {
+            lock_guard<mutex> queueLock(queueMutex);
+            if (written) {
+                if (durableSequence.load() < batchEnd) durableSequence = batchEnd;
+            } else if (file) {
+                pending.insert(0, batch);
+            }
+        }
+        batch.clear();
+        durableAdvanced.notify_all();
+        if (stop) return;
+    }
+}
+
+// Append one batch, with the file lock held. If the write fails, the file
+// is cut back to where the batch started so that a retry neither repeats
+// records nor joins one to a half-written line. If it cannot be cut back,
+// the journal is closed rather than left with a torn record in the middle.
+bool Journal::writeBatch(const string& batch, JournalSync policy) {
+    long start = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    if (start >= 0 && fwrite(batch.data(), 1, batch.size(), file) == batch.size() &&
+        (policy == JournalSync::EVERY_BATCH ? syncFile(file) : fflush(file) == 0)) {
+        if (writeFailed) cerr << "Journal writes resumed: " << path << endl;
+        writeFailed = false;
+        return true;
+    }
+    // Retried every flush interval; report only the first failure
+    if (!writeFailed) cerr << "Error: Failed to write journal, retrying: " << path << endl;
+    writeFailed = true;
+
+    fclose(file);
+    error_code error;
+    if (start >= 0) filesystem::resize_file(path, static_cast<uintmax_t>(start), error);
+    FILE* reopened = start >= 0 && !error ? fopen(path.c_str(), "a") : nullptr;
+    if (!reopened) {
+        cerr << "Error: Could not remove failed journal write, journal closed: " << path << endl;
+    }
+    lock_guard<mutex> queueLock(queueMutex);
+    file = reopened;
+    return false;
+}
+
+// Drop the records up to `sequence`, which a checkpoint now covers, and keep
+// the later ones. Queued records are folded in, and the rest is written to a
+// temporary file that replaces the journal. The queued records only count as
+// durable once they are on disk: in the new journal, synced with its
+// directory under EVERY_BATCH, or else appended to the old journal the way
+// the writer appends a batch.
+void Journal::truncateThrough(uint64_t sequence) {
+    lock_guard<mutex> fileLock(fileMutex);
+    string contents;
+    uint64_t dropCount;
+    uint64_t batchEnd;
+    JournalSync policy;
+    {
+        lock_guard<mutex> queueLock(queueMutex);
+        if (sequence <= baseSequence) return;
+        dropCount = min(sequence, lastSequence) - baseSequence;
+        batchEnd = lastSequence;
+        policy = syncPolicy;
+        contents.swap(pending);
+        pending.clear();
+    }
+
+    if (file) fflush(file);
+    ifstream existing(path, ios::binary);
+    string onDisk((istreambuf_iterator<char>(existing)), istreambuf_iterator<char>());
+    existing.close();
+    string queued = contents;
+    contents.insert(0, onDisk);
+
+    size_t cut = 0;
+    for (uint64_t i = 0; i < dropCount && cut < contents.size(); ++i) {
+        size_t newline = contents.find('\n', cut);
+        cut = newline == string::npos ? contents.size() : newline + 1;
+    }
+    size_t kept = static_cast<size_t>(count(contents.begin() + cut, contents.end(), '\n'));
+
+    string tempPath = path + ".tmp";
+    FILE* temp = fopen(tempPath.c_str(), "w");
+    bool written = temp && fwrite(contents.data() + cut, 1, contents.size() - cut, temp) ==
+                               contents.size() - cut &&
+                   (policy != JournalSync::EVERY_BATCH || syncFile(temp));
+    if (temp) written = fclose(temp) == 0 && written;
+
+    bool wasOpen = file != nullptr;
+    if (file) fclose(file);
+#ifdef _WIN32
+    if (written) remove(path.c_str());
+#endif
+    bool replaced = written && rename(tempPath.c_str(), path.c_str()) == 0;
+    if (!replaced) {
+        cerr << "Error: Could not rewrite journal: " << path << endl;
+    }
+    bool synced = !replaced || policy != JournalSync::EVERY_BATCH || syncDirectory(path);
+    if (!synced) {
+        cerr << "Error: Could not sync the journal directory: " << path << endl;
+    }
+    FILE* reopened = nullptr;
+    if (wasOpen && synced) {
+        reopened = fopen(path.c_str(), "a");
+    }
+    if (wasOpen && !reopened) {
+        cerr << "Error: Could not reopen journal, journal closed: " << path << endl;
+    }
+
+    {
+        lock_guard<mutex> queueLock(queueMutex);
+        file = reopened;
+        if (replaced) {
+            baseSequence = sequence;
+            recordCount = kept;
+        }
+    }
+
+    // Not replaced: keep the old journal and append the queued records to it
+    bool durable = replaced && synced;
+    if (!replaced && reopened) {
+        durable = queued.empty() || writeBatch(queued, policy);
+    }
+    {
+        lock_guard<mutex> queueLock(queueMutex);
+        if (durable) {
+            if (durableSequence.load() < batchEnd) durableSequence = batchEnd;
+        } else if (file) {
+            pending.insert(0, queued);
+        }
+    }
+    durableAdvanced.notify_all();
+}
+
+size_t Journal::size() const {
+    lock_guard<mutex> queueLock(queueMutex);
+    return recordCount;
+}
+
+uint64_t Journal::getLastSequence() const {
+    lock_guard<mutex> queueLock(queueMutex);
+    return lastSequence;
+}
+
+uint64_t Journal::getDurableSequence() const { return durableSequence.load(); }
+const string& Journal::getPath() const { return path; }
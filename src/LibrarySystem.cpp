@@ -1,81 +1,121 @@
 #include "../header/LibrarySystem.h"
+#include "../header/DataParser.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <cctype>
+#include <thread>
+#include <exception>
+#include <mutex>
 
 using namespace std;
 
-// Helper function implementation
-vector<string> Library::split(const string& str, char delim) {
-    vector<string> tokens;
-    string token;
-    istringstream tokenStream(str);
-    while (getline(tokenStream, token, delim)) {
-        tokens.push_back(token);
-    }
-    return tokens;
+// ReservationQueue Implementation
+ReservationQueue::ReservationQueue(const ReservationQueue& other) {
+    for (int userID : other.order) push(userID);
 }
 
-// readDataFile implementation
-template<typename Func>
-void Library::readDataFile(const string& filename, Func&& callback) {
-    ifstream file(filename);
-    if (file.is_open()) {
-        string line;
-        while (getline(file, line)) {
-            auto parts = split(line, '|');
-            callback(parts);
-        }
-        file.close();
+ReservationQueue& ReservationQueue::operator=(const ReservationQueue& other) {
+    if (this != &other) {
+        order.clear();
+        positions.clear();
+        for (int userID : other.order) push(userID);
     }
+    return *this;
+}
+
+bool ReservationQueue::push(int userID) {
+    if (positions.count(userID)) return false;
+    order.push_back(userID);
+    positions[userID] = prev(order.end());
+    return true;
+}
+
+bool ReservationQueue::remove(int userID) {
+    auto it = positions.find(userID);
+    if (it == positions.end()) return false;
+    order.erase(it->second);
+    positions.erase(it);
+    return true;
 }
 
+int ReservationQueue::pop() {
+    int userID = order.front();
+    positions.erase(userID);
+    order.pop_front();
+    return userID;
+}
+
+int ReservationQueue::front() const { return order.front(); }
+bool ReservationQueue::contains(int userID) const { return positions.count(userID) > 0; }
+bool ReservationQueue::empty() const { return order.empty(); }
+size_t ReservationQueue::size() const { return order.size(); }
+const list<int>& ReservationQueue::getOrder() const { return order; }
+
 // Book Implementation
+const int Book::MIN_COPIES;
+
 Book::Book(int id, const string& title, const string& author, 
-           const string& publisher, int year, const string& isbn)
-    : bookID(id), title(title), author(author), publisher(publisher), 
-      year(year), ISBN(isbn), available(true) {}
+           const string& publisher, int year, const string& isbn, int copies)
+    : bookID(id), title(title), author(StringPool::global().intern(author)),
+      publisher(StringPool::global().intern(publisher)), year(year), ISBN(isbn),
+      copies(copies), availableCopies(copies) {}
 
 int Book::getBookID() const { return bookID; }
-string Book::getTitle() const { return title; }
-string Book::getAuthor() const { return author; }
-string Book::getPublisher() const { return publisher; }
+const string& Book::getTitle() const { return title; }
+const string& Book::getAuthor() const { return StringPool::global().get(author); }
+const string& Book::getPublisher() const { return StringPool::global().get(publisher); }
+StringHandle Book::getAuthorHandle() const { return author; }
+StringHandle Book::getPublisherHandle() const { return publisher; }
 int Book::getYear() const { return year; }
-string Book::getISBN() const { return ISBN; }
-bool Book::isAvailable() const { return available; }
-void Book::setAvailable(bool status) { available = status; }
+const string& Book::getISBN() const { return ISBN; }
+int Book::getCopies() const { return copies; }
+int Book::getAvailableCopies() const { return availableCopies.load(memory_order_relaxed); }
+bool Book::isAvailable() const { return getAvailableCopies() > 0; }
+
+// Change the number of copies held, keeping the ones on loan checked out.
+// Fails if fewer than one copy would remain or if more copies are on loan.
+bool Book::setCopies(int count) {
+    int onLoan = copies - getAvailableCopies();
+    if (count < MIN_COPIES || count < onLoan) return false;
+    availableCopies.fetch_add(count - copies, memory_order_relaxed);
+    copies = count;
+    return true;
+}
+
+// Take one copy off the shelf; false if none is left
+bool Book::checkOut() {
+    int current = getAvailableCopies();
+    while (current > 0) {
+        if (availableCopies.compare_exchange_weak(current, current - 1, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Book::checkIn() {
+    int current = getAvailableCopies();
+    while (current < copies) {
+        if (availableCopies.compare_exchange_weak(current, current + 1, memory_order_relaxed)) {
+            return;
+        }
+    }
+}
 
 bool Book::reserve(int userID) {
     if (isReservedBy(userID)) {
         return false;
     }
-    if (!available) {
-        reservationQueue.push(userID);
-        return true;
+    if (!isAvailable()) {
+        return reservationQueue.push(userID);
     }
     return false;
 }
 
 bool Book::cancelReservation(int userID) {
-    if (reservationQueue.empty() || !isReservedBy(userID)) return false;
-    
-    queue<int> tempQueue;
-    bool found = false;
-    
-    while (!reservationQueue.empty()) {
-        int currentID = reservationQueue.front();
-        reservationQueue.pop();
-        
-        if (currentID != userID) {
-            tempQueue.push(currentID);
-        } else {
-            found = true;
-        }
-    }
-    
-    reservationQueue = tempQueue;
-    return found;
+    return reservationQueue.remove(userID);
 }
 
 bool Book::isReserved() const {
@@ -84,24 +124,36 @@ bool Book::isReserved() const {
 
 int Book::getNextReservation() {
     if (reservationQueue.empty()) return -1;
-    int nextUser = reservationQueue.front();
-    reservationQueue.pop();
-    return nextUser;
+    return reservationQueue.pop();
 }
 
 bool Book::isReservedBy(int userID) const {
-    queue<int> tempQueue = reservationQueue;
-    while (!tempQueue.empty()) {
-        if (tempQueue.front() == userID) return true;
-        tempQueue.pop();
-    }
-    return false;
+    return reservationQueue.contains(userID);
+}
+
+vector<int> Book::getReservations() const {
+    const auto& order = reservationQueue.getOrder();
+    return vector<int>(order.begin(), order.end());
+}
+
+// Re-queue a reservation read back from disk, bypassing the availability check
+void Book::restoreReservation(int userID) {
+    reservationQueue.push(userID);
 }
 
+// The copies on the shelf are held for the front of the reservation queue:
+// a reserving user can borrow if they are within the first N queued users,
+// anyone else only if there are more copies than queued users.
 bool Book::isAvailableFor(int userID) const {
-    if (!available) return false;
-    if (reservationQueue.empty()) return true;
-    return reservationQueue.front() == userID;
+    size_t onShelf = static_cast<size_t>(max(getAvailableCopies(), 0));
+    if (onShelf == 0) return false;
+    if (onShelf > reservationQueue.size()) return true;
+    size_t position = 0;
+    for (int queuedUserID : reservationQueue.getOrder()) {
+        if (position++ == onShelf) break;
+        if (queuedUserID == userID) return true;
+    }
+    return false;
 }
 
 // Account Implementation
@@ -114,6 +166,10 @@ void Account::addBorrow(int bookID) {
     currentBorrows.push_back(record);
 }
 
+void Account::addBorrow(const BorrowRecord& record) {
+    currentBorrows.push_back(record);
+}
+
 void Account::removeBorrow(int bookID) {
     auto it = find_if(currentBorrows.begin(), currentBorrows.end(),
         [bookID](const BorrowRecord& record) { return record.bookID == bookID; });
@@ -124,6 +180,7 @@ void Account::removeBorrow(int bookID) {
     }
 }
 
+int Account::getUserID() const { return userID; }
 const vector<BorrowRecord>& Account::getCurrentBorrows() const { return currentBorrows; }
 const vector<BorrowRecord>& Account::getBorrowHistory() const { return borrowHistory; }
 double Account::getTotalFine() const { return totalFine; }
@@ -132,77 +189,196 @@ void Account::payFine(double amount) { totalFine = max(0.0, totalFine - amount);
 void Account::addToBorrowHistory(const BorrowRecord& record) { borrowHistory.push_back(record); }
 
 // User Implementation
-User::User(int id, const string& name, const string& password)
-    : userID(id), name(name), password(password) {}
+User::User(int id, const string& name, const string& password, RoleID role)
+    : userID(id), name(name), password(password), department(0), role(role) {}
 
 int User::getUserID() const { return userID; }
 string User::getName() const { return name; }
-string User::getRole() const { return role; }
-string User::getDepartment() const { return department; }
-void User::setDepartment(const string& dept) { department = dept; }
+string User::getRole() const { return getPolicy().name; }
+const string& User::getDepartment() const { return StringPool::global().get(department); }
+StringHandle User::getDepartmentHandle() const { return department; }
+void User::setDepartment(const string& dept) { department = StringPool::global().intern(dept); }
 
 // Student Implementation
 Student::Student(int id, const string& name, const string& password)
-    : User(id, name, password) {
-    role = "Student";
-}
+    : User(id, name, password, ROLE_STUDENT) {}
 
 // Faculty Implementation
 Faculty::Faculty(int id, const string& name, const string& password)
-    : User(id, name, password) {
-    role = "Faculty";
-}
+    : User(id, name, password, ROLE_FACULTY) {}
 
 // Librarian Implementation
 Librarian::Librarian(int id, const string& name, const string& password)
-    : User(id, name, password) {
-    role = "Librarian";
-}
+    : User(id, name, password, ROLE_LIBRARIAN) {}
 
 // Library Implementation
-Library::~Library() = default;
+Library::Library() {
+    checkpointer = thread(&Library::checkpointLoop, this);
+}
+
+// Stop the checkpointer first: it reads every member. A checkpoint already
+// running is finished, one only flagged is dropped; the journal still holds
+// its records.
+Library::~Library() {
+    {
+        lock_guard<mutex> checkpointLock(checkpointMutex);
+        checkpointStopping = true;
+    }
+    checkpointWake.notify_one();
+    checkpointer.join();
+}
+
+// Lock helpers. The catalog lock guards the structure of the maps and the
+// search index; stripe locks guard the state of individual books and
+// accounts. Lock order is always catalog, then book stripe, then account
+// stripe.
+shared_mutex& Library::bookStripe(int bookID) const {
+    return bookLocks[static_cast<unsigned>(bookID) % LOCK_STRIPES];
+}
+
+shared_mutex& Library::accountStripe(int userID) const {
+    return accountLocks[static_cast<unsigned>(userID) % LOCK_STRIPES];
+}
+
+// Unlocked lookups for callers that already hold the catalog lock
+Book* Library::findBook(int bookID) const {
+    auto it = books.find(bookID);
+    return it != books.end() ? it->second.get() : nullptr;
+}
+
+User* Library::findUser(int userID) const {
+    auto it = users.find(userID);
+    return it != users.end() ? it->second.get() : nullptr;
+}
+
+Account* Library::findAccount(int userID) const {
+    auto it = accounts.find(userID);
+    return it != accounts.end() ? it->second.get() : nullptr;
+}
 
 bool Library::addBook(unique_ptr<Book> book) {
+    unique_lock<shared_mutex> catalogLock(catalogMutex);
+    return insertBook(adoptHeap(move(book)));
+}
+
+bool Library::removeBook(int bookID) {
+    unique_lock<shared_mutex> catalogLock(catalogMutex);
+    return eraseBook(bookID);
+}
+
+bool Library::setCopies(int bookID, int copies) {
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    Book* book = findBook(bookID);
+    if (!book) return false;
+
+    unique_lock<shared_mutex> bookLock(bookStripe(bookID));
+    touchBook(book);
+    if (!book->setCopies(copies)) return false;
+    bookColumns.setAvailable(bookID, book->isAvailable());
+    markChanged(CHANGED_BOOKS);
+    logMutation("COPIES|" + to_string(bookID) + "|" + to_string(copies));
+    return true;
+}
+
+bool Library::addUser(unique_ptr<User> user) {
+    unique_lock<shared_mutex> catalogLock(catalogMutex);
+    return insertUser(adoptHeap(move(user)));
+}
+
+bool Library::removeUser(int userID) {
+    unique_lock<shared_mutex> catalogLock(catalogMutex);
+    return eraseUser(userID);
+}
+
+bool Library::insertBook(PoolPtr<Book> book) {
     int bookID = book->getBookID();
+    if (book->getCopies() < Book::MIN_COPIES) {
+        cerr << "Error: Book " << bookID << " must have at least " << Book::MIN_COPIES
+             << " copy" << endl;
+        return false;
+    }
     if (books.find(bookID) != books.end()) return false;
+    // Loads insert with the journal closed; skip building a record for them
+    string record;
+    if (journal.isOpen()) {
+        record = "ADDBOOK|" + to_string(bookID) + "|" + book->getTitle() + "|" +
+                 book->getAuthor() + "|" + book->getPublisher() + "|" +
+                 to_string(book->getYear()) + "|" + book->getISBN() + "|" +
+                 to_string(book->getCopies());
+    }
+    indexBook(*book);
+    bookColumns.append(*book);
     books[bookID] = move(book);
+    markChanged(CHANGED_BOOKS);
+    if (!record.empty()) logMutation(record);
     return true;
 }
 
-bool Library::removeBook(int bookID) {
-    return books.erase(bookID) > 0;
+bool Library::eraseBook(int bookID) {
+    auto bookIt = books.find(bookID);
+    if (bookIt == books.end()) return false;
+    unindexBook(*bookIt->second);
+    bookColumns.erase(bookID);
+    markChanged(CHANGED_BOOKS | (bookIt->second->isReserved() ? CHANGED_RESERVATIONS : 0));
+    for (int userID : bookIt->second->getReservations()) {
+        unindexReservation(userID, bookID);
+    }
+    books.erase(bookIt);
+    logMutation("REMOVEBOOK|" + to_string(bookID));
+    return true;
 }
 
-bool Library::addUser(unique_ptr<User> user) {
+bool Library::insertUser(PoolPtr<User> user) {
     int userID = user->getUserID();
     if (users.find(userID) != users.end()) return false;
-    accounts[userID] = make_unique<Account>(userID);
+    string record = "ADDUSER|" + user->getRole() + "|" + to_string(userID) + "|" +
+                    user->getName() + "|" + user->getPassword() + "|" + user->getDepartment();
+    accounts[userID] = makePooled<Account>(accountPool, userID);
+    markChanged(changedUserFile(user->getRoleID()));
+    markAccountChanged(userID);
     users[userID] = move(user);
+    logMutation(record);
     return true;
 }
 
-bool Library::removeUser(int userID) {
-    accounts.erase(userID);
-    return users.erase(userID) > 0;
+bool Library::eraseUser(int userID) {
+    auto userIt = users.find(userID);
+    if (userIt == users.end()) return false;
+    markChanged(changedUserFile(userIt->second->getRoleID()));
+    markAccountChanged(userID);
+
+    auto accountIt = accounts.find(userID);
+    if (accountIt != accounts.end()) {
+        for (const auto& record : accountIt->second->getCurrentBorrows()) {
+            unindexLoan(userID, record);
+        }
+        accounts.erase(accountIt);
+    }
+    users.erase(userIt);
+    logMutation("REMOVEUSER|" + to_string(userID));
+    return true;
 }
 
 bool Library::borrowBook(int userID, int bookID) {
-    auto userIt = users.find(userID);
-    auto bookIt = books.find(bookID);
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    const User* user = findUser(userID);
+    Book* book = findBook(bookID);
+    Account* account = findAccount(userID);
     
     // Check if user and book exist
-    if (userIt == users.end() || bookIt == books.end()) return false;
+    if (!user || !book || !account) return false;
     
     // Check if user can borrow (not a librarian)
-    if (!userIt->second->canBorrow()) return false;
-    
-    // Check if book is available
-    if (!bookIt->second->isAvailable()) return false;
+    if (!user->canBorrow()) return false;
     
-    auto account = accounts[userID].get();
+    unique_lock<shared_mutex> bookLock(bookStripe(bookID));
+    unique_lock<shared_mutex> accountLock(accountStripe(userID));
+
+    // Check if a copy is available
+    if (!book->isAvailable()) return false;
     
     // Check borrowing limit
-    if (account->getCurrentBorrows().size() >= userIt->second->getMaxBooks()) return false;
+    if (account->getCurrentBorrows().size() >= user->getMaxBooks()) return false;
     
     // Check if user already has this book
     for (const auto& borrow : account->getCurrentBorrows()) {
@@ -213,22 +389,32 @@ bool Library::borrowBook(int userID, int bookID) {
     if (account->getTotalFine() > 0) return false;
     
     // Proceed with borrowing
-    bookIt->second->setAvailable(false);
+    touchBook(book);
+    touchAccount(account);
+    if (!checkOutCopy(book)) return false;
     account->addBorrow(bookID);
-    saveState();  // Save state after borrowing
+
+    const BorrowRecord& record = account->getCurrentBorrows().back();
+    indexLoan(userID, record);
+    markAccountChanged(userID);
+    logMutation("BORROW|" + to_string(userID) + "|" + to_string(bookID) + "|" +
+                to_string(chrono::system_clock::to_time_t(record.borrowDate)) + "|" +
+                to_string(chrono::system_clock::to_time_t(record.dueDate)));
     return true;
 }
 
 bool Library::returnBook(int userID, int bookID) {
-    auto userIt = users.find(userID);
-    auto bookIt = books.find(bookID);
-    
-    // Check if user and book exist
-    if (userIt == users.end() || bookIt == books.end()) return false;
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    const User* user = findUser(userID);
+    Book* book = findBook(bookID);
+    Account* account = findAccount(userID);
     
-    auto account = accounts[userID].get();
-    if (!account) return false;
+    // Check if user, book and account exist
+    if (!user || !book || !account) return false;
     
+    unique_lock<shared_mutex> bookLock(bookStripe(bookID));
+    unique_lock<shared_mutex> accountLock(accountStripe(userID));
+
     // Check if user has borrowed this book
     bool hasBorrowed = false;
     for (const auto& borrow : account->getCurrentBorrows()) {
@@ -240,323 +426,1440 @@ bool Library::returnBook(int userID, int bookID) {
     if (!hasBorrowed) return false;
     
     // Calculate fine if overdue
+    double fine = 0.0;
     auto now = chrono::system_clock::now();
     for (const auto& borrow : account->getCurrentBorrows()) {
         if (borrow.bookID == bookID && now > borrow.dueDate) {
             auto overdueHours = chrono::duration_cast<chrono::hours>(now - borrow.dueDate).count();
-            double fine = overdueHours * userIt->second->getFineRate();
-            account->addFine(fine);
+            fine = overdueHours * user->getFineRate();
             break;
         }
     }
     
+    applyReturn(account, book, fine);
+    logMutation("RETURN|" + to_string(userID) + "|" + to_string(bookID) + "|" + to_string(fine));
+    return true;
+}
+
+// Shared by returnBook and journal replay so both produce the same state
+void Library::applyReturn(Account* account, Book* book, double fine) {
+    touchBook(book);
+    touchAccount(account);
+    markAccountChanged(account->getUserID());
+    if (fine > 0) account->addFine(fine);
+
     // Remove the borrow record
-    account->removeBorrow(bookID);
+    for (const auto& record : account->getCurrentBorrows()) {
+        if (record.bookID == book->getBookID()) {
+            unindexLoan(account->getUserID(), record);
+            break;
+        }
+    }
+    account->removeBorrow(book->getBookID());
     
-    // Set book as available
-    bookIt->second->setAvailable(true);
+    // Put the copy back on the shelf
+    checkInCopy(book);
     
     // If there are reservations, notify the first person in queue
-    if (bookIt->second->isReserved()) {
-        int nextUserID = bookIt->second->getNextReservation();
-        bookIt->second->reserve(nextUserID);
+    if (book->isReserved()) {
+        markChanged(CHANGED_RESERVATIONS);
+        int nextUserID = book->getNextReservation();
+        if (!book->reserve(nextUserID)) {
+            unindexReservation(nextUserID, book->getBookID());
+        }
     }
-    
-    saveState();
+}
+
+// Every availability change after a book is inserted goes through these so
+// the column copy stays in sync
+bool Library::checkOutCopy(Book* book) {
+    if (!book->checkOut()) return false;
+    bookColumns.setAvailable(book->getBookID(), book->isAvailable());
+    return true;
+}
+
+void Library::checkInCopy(Book* book) {
+    book->checkIn();
+    bookColumns.setAvailable(book->getBookID(), book->isAvailable());
+}
+
+bool Library::applyReserve(Book* book, int userID) {
+    touchBook(book);
+    if (!book->reserve(userID)) return false;
+    indexReservation(userID, book->getBookID());
+    markChanged(CHANGED_RESERVATIONS);
     return true;
 }
 
+bool Library::applyCancel(Book* book, int userID) {
+    touchBook(book);
+    if (!book->cancelReservation(userID)) return false;
+    unindexReservation(userID, book->getBookID());
+    markChanged(CHANGED_RESERVATIONS);
+    return true;
+}
+
+void Library::restoreReservation(Book* book, int userID) {
+    book->restoreReservation(userID);
+    indexReservation(userID, book->getBookID());
+}
+
+void Library::indexReservation(int userID, int bookID) {
+    unique_lock<shared_mutex> indexLock(reservationIndexMutex);
+    reservationsByUser[userID].insert(bookID);
+}
+
+void Library::indexLoan(int userID, const BorrowRecord& record) {
+    lock_guard<mutex> indexLock(dueIndexMutex);
+    dueIndex.insert({record.dueDate, userID, record.bookID, record.borrowDate});
+}
+
+void Library::unindexLoan(int userID, const BorrowRecord& record) {
+    lock_guard<mutex> indexLock(dueIndexMutex);
+    dueIndex.erase({record.dueDate, userID, record.bookID, record.borrowDate});
+}
+
+void Library::unindexReservation(int userID, int bookID) {
+    unique_lock<shared_mutex> indexLock(reservationIndexMutex);
+    auto it = reservationsByUser.find(userID);
+    if (it == reservationsByUser.end()) return;
+    it->second.erase(bookID);
+    if (it->second.empty()) reservationsByUser.erase(it);
+}
+
 bool Library::authenticateUser(int userID, const string& password) const {
-    auto it = users.find(userID);
-    return (it != users.end() && it->second->verifyPassword(password));
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    const User* user = findUser(userID);
+    return user && user->verifyPassword(password);
 }
 
 bool Library::payFine(int userID, double amount) {
-    auto accountIt = accounts.find(userID);
-    if (accountIt == accounts.end()) return false;
-    accountIt->second->payFine(amount);
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    Account* account = findAccount(userID);
+    if (!account) return false;
+    unique_lock<shared_mutex> accountLock(accountStripe(userID));
+    touchAccount(account);
+    account->payFine(amount);
+    markAccountChanged(userID);
+    logMutation("PAY|" + to_string(userID) + "|" + to_string(amount));
     return true;
 }
 
+// The returned pointers stay valid until the entity is removed; reading
+// through them is not synchronized with concurrent circulation.
 const Book* Library::getBook(int bookID) const {
-    auto it = books.find(bookID);
-    return it != books.end() ? it->second.get() : nullptr;
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    return findBook(bookID);
+}
+
+// Scanned or typed ISBNs are normalized the same way as the catalog's, so
+// "0-306-40615-2" and "9780306406157" find the same book. When several books
+// share an ISBN the lowest bookID is returned.
+const Book* Library::getBookByISBN(const string& isbn) const {
+    uint64_t isbnKey;
+    if (!normalizeISBN(isbn, isbnKey)) return nullptr;
+
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    auto range = isbnIndex.equal_range(isbnKey);
+    if (range.first == range.second) return nullptr;
+    int bookID = range.first->second;
+    for (auto it = range.first; it != range.second; ++it) {
+        bookID = min(bookID, it->second);
+    }
+    return findBook(bookID);
+}
+
+bool Library::normalizeISBN(const string& isbn, uint64_t& key) {
+    string digits;
+    for (char c : isbn) {
+        if (isdigit(static_cast<unsigned char>(c))) {
+            digits += c;
+        } else if ((c == 'X' || c == 'x') && digits.size() == 9) {
+            digits += 'X';  // ISBN-10 check digit
+        } else if (c != '-' && c != ' ') {
+            return false;
+        }
+    }
+
+    if (digits.size() == 10) {
+        // ISBN-10 -> ISBN-13: prefix 978 and recompute the EAN-13 check digit
+        digits = "978" + digits.substr(0, 9);
+        int sum = 0;
+        for (size_t i = 0; i < 12; ++i) {
+            sum += (digits[i] - '0') * (i % 2 ? 3 : 1);
+        }
+        digits += static_cast<char>('0' + (10 - sum % 10) % 10);
+    }
+    if (digits.size() != 13 || digits.find('X') != string::npos) return false;
+
+    key = 0;
+    for (char c : digits) key = key * 10 + (c - '0');
+    return true;
 }
 
 const User* Library::getUser(int userID) const {
-    auto it = users.find(userID);
-    return it != users.end() ? it->second.get() : nullptr;
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    return findUser(userID);
 }
 
 Account* Library::getAccount(int userID) const {
-    auto it = accounts.find(userID);
-    return it != accounts.end() ? it->second.get() : nullptr;
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    return findAccount(userID);
 }
 
+// Split text into lowercase alphanumeric terms, e.g. "Midnight's Children"
+// becomes {"midnight", "s", "children"}
+vector<string> Library::tokenize(const string& text) {
+    vector<string> terms;
+    string term;
+    for (char c : text) {
+        if (isalnum(static_cast<unsigned char>(c))) {
+            term += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        } else if (!term.empty()) {
+            terms.push_back(term);
+            term.clear();
+        }
+    }
+    if (!term.empty()) terms.push_back(term);
+    return terms;
+}
+
+void Library::indexBook(const Book& book) {
+    int bookID = book.getBookID();
+    vector<string> terms;
+    if (indexMode != IndexMode::PRELOADED) {
+        terms = tokenize(book.getTitle() + " " + book.getAuthor());
+    }
+    for (const auto& term : terms) {
+        auto& postings = searchIndex[term];
+        if (indexMode == IndexMode::BULK) {
+            // Sorted, weighted and added to the trigram index once loading ends
+            if (postings.empty() || postings.back() != bookID) postings.push_back(bookID);
+            continue;
+        }
+        auto pos = lower_bound(postings.begin(), postings.end(), bookID);
+        if (pos == postings.end() || *pos != bookID) {
+            postings.insert(pos, bookID);
+            termTrie.setWeight(term, static_cast<uint32_t>(postings.size()));
+            if (postings.size() == 1) termGrams.addTerm(term);
+        }
+    }
+
+    uint64_t isbnKey;
+    if (normalizeISBN(book.getISBN(), isbnKey)) {
+        isbnIndex.emplace(isbnKey, bookID);
+    }
+}
+
+// Loads append to the posting lists in whatever order the books arrive (the
+// snapshot holds them in hash-map order), so inserting each one in place would
+// be quadratic. Sort every list once, then build the prefix trie and trigram
+// index from the finished term set.
+void Library::finishBulkIndex() {
+    for (auto& entry : searchIndex) {
+        auto& postings = entry.second;
+        if (!is_sorted(postings.begin(), postings.end())) {
+            sort(postings.begin(), postings.end());
+        }
+        termTrie.setWeight(entry.first, static_cast<uint32_t>(postings.size()));
+        termGrams.addTerm(entry.first);
+    }
+    indexMode = IndexMode::LIVE;
+}
+
+void Library::unindexBook(const Book& book) {
+    int bookID = book.getBookID();
+    for (const auto& term : tokenize(book.getTitle() + " " + book.getAuthor())) {
+        auto indexIt = searchIndex.find(term);
+        if (indexIt == searchIndex.end()) continue;
+        auto& postings = indexIt->second;
+        auto pos = lower_bound(postings.begin(), postings.end(), bookID);
+        if (pos != postings.end() && *pos == bookID) {
+            postings.erase(pos);
+            termTrie.setWeight(term, static_cast<uint32_t>(postings.size()));
+        }
+        if (postings.empty()) {
+            termGrams.removeTerm(term);
+            searchIndex.erase(indexIt);
+        }
+    }
+
+    uint64_t isbnKey;
+    if (normalizeISBN(book.getISBN(), isbnKey)) {
+        auto range = isbnIndex.equal_range(isbnKey);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == bookID) {
+                isbnIndex.erase(it);
+                break;
+            }
+        }
+    }
+}
+
+// A book matches if its title or author contains the query, ignoring case,
+// or if it holds every query word as a whole word in any order. Whole-word
+// matches come from intersecting the posting lists of the query terms,
+// shortest first. Substring matches are verified against candidates from
+// the terms that contain each query word; when a word is too short or too
+// common for that to pay off, the column text arena is scanned instead.
+// Results are in book ID order.
 vector<const Book*> Library::searchBooks(const string& query) const {
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    vector<string> words = tokenize(query);
+    vector<int> matches;
+
+    vector<const vector<int>*> postingLists;
+    for (const auto& term : words) {
+        auto indexIt = searchIndex.find(term);
+        if (indexIt == searchIndex.end()) break;
+        postingLists.push_back(&indexIt->second);
+    }
+
+    if (!words.empty() && postingLists.size() == words.size()) {
+        sort(postingLists.begin(), postingLists.end(),
+            [](const vector<int>* a, const vector<int>* b) { return a->size() < b->size(); });
+
+        for (int bookID : *postingLists.front()) {
+            bool inAll = true;
+            for (size_t i = 1; i < postingLists.size() && inAll; ++i) {
+                inAll = binary_search(postingLists[i]->begin(), postingLists[i]->end(), bookID);
+            }
+            if (inAll) {
+                matches.push_back(bookID);
+            }
+        }
+    }
+
+    vector<int> candidates;
+    if (findSubstringCandidates(words, candidates)) {
+        TextScan scan(query);
+        for (int bookID : candidates) {
+            size_t row = bookColumns.findRow(bookID);
+            if (row != BookColumns::NO_ROW &&
+                scan.find(bookColumns.getSearchText(row), 0) != string_view::npos) {
+                matches.push_back(bookID);
+            }
+        }
+    } else {
+        // Vectorized substring scan over the column text arena
+        for (const Book* book : bookColumns.findText(query)) {
+            matches.push_back(book->getBookID());
+        }
+    }
+
+    sort(matches.begin(), matches.end());
+    matches.erase(unique(matches.begin(), matches.end()), matches.end());
     vector<const Book*> results;
-    string lowerQuery = query;
-    transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
-    
-    for (const auto& pair : books) {
-        string title = pair.second->getTitle();
-        transform(title.begin(), title.end(), title.begin(), ::tolower);
-        if (title.find(lowerQuery) != string::npos) {
-            results.push_back(pair.second.get());
+    results.reserve(matches.size());
+    for (int bookID : matches) {
+        if (const Book* book = findBook(bookID)) {
+            results.push_back(book);
         }
     }
     return results;
 }
 
-bool Library::reserveBook(int userID, int bookID) {
-    auto bookIt = books.find(bookID);
-    if (bookIt == books.end()) return false;
-    bool success = bookIt->second->reserve(userID);
-    if (success) {
-        saveState();  // Save state after successful reservation
+// Books that may contain the query as a substring: each query word then lies
+// inside one of the book's terms. Returns false if the scan is cheaper, i.e.
+// for an empty query, a word shorter than a trigram, or words whose
+// containing terms cover a large share of the catalog.
+bool Library::findSubstringCandidates(const vector<string>& words, vector<int>& candidates) const {
+    size_t limit = books.size() / 8;
+    bool first = true;
+    candidates.clear();
+    for (const auto& word : words) {
+        if (word.size() < 3) return false;
+    }
+    if (words.empty()) return false;
+
+    vector<int> wordBooks;
+    vector<int> common;
+    for (const auto& word : words) {
+        wordBooks.clear();
+        for (const auto& term : termGrams.findContaining(word)) {
+            const vector<int>& postings = searchIndex.at(term);
+            if (wordBooks.size() + postings.size() > limit) return false;
+            wordBooks.insert(wordBooks.end(), postings.begin(), postings.end());
+        }
+        sort(wordBooks.begin(), wordBooks.end());
+        wordBooks.erase(unique(wordBooks.begin(), wordBooks.end()), wordBooks.end());
+
+        if (first) {
+            candidates.swap(wordBooks);
+            first = false;
+        } else {
+            common.clear();
+            set_intersection(candidates.begin(), candidates.end(), wordBooks.begin(), wordBooks.end(),
+                             back_inserter(common));
+            candidates.swap(common);
+        }
+        if (candidates.empty()) break;
     }
-    return success;
+    return true;
 }
 
-bool Library::cancelReservation(int userID, int bookID) {
-    auto bookIt = books.find(bookID);
-    if (bookIt == books.end()) return false;
-    bool success = bookIt->second->cancelReservation(userID);
-    if (success) {
-        saveState();  // Save state after successful cancellation
+// Typo-tolerant search. Each query word of three or more characters is
+// matched against the index vocabulary through the trigram index, allowing
+// more edits for longer words; shorter words are too ambiguous to correct and
+// are ignored. A book must match every remaining word through some close
+// term and is ranked by the total edit distance of its best matches.
+vector<const Book*> Library::fuzzySearch(const string& query, size_t limit) const {
+    vector<const Book*> results;
+    vector<string> words;
+    for (auto& term : tokenize(query)) {
+        if (term.size() >= 3) words.push_back(move(term));
     }
-    return success;
+    if (words.empty() || limit == 0) return results;
+
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+
+    // Per word: posting lists of its close terms, closest term first
+    using TermPostings = vector<pair<int, const vector<int>*>>;
+    vector<TermPostings> wordPostings(words.size());
+    vector<size_t> wordBookCounts(words.size(), 0);
+    for (size_t i = 0; i < words.size(); ++i) {
+        int maxDistance = words[i].size() <= 4 ? 1 : words[i].size() <= 6 ? 2 : 3;
+        for (const auto& match : termGrams.findSimilar(words[i], maxDistance)) {
+            const vector<int>& postings = searchIndex.at(match.term);
+            wordPostings[i].emplace_back(match.distance, &postings);
+            wordBookCounts[i] += postings.size();
+        }
+        if (wordPostings[i].empty()) return results;
+    }
+
+    // Smallest distance at which a word's terms contain bookID, or -1
+    auto distanceFor = [](const TermPostings& postings, size_t end, int bookID) {
+        for (size_t k = 0; k < end; ++k) {
+            if (binary_search(postings[k].second->begin(), postings[k].second->end(), bookID)) {
+                return postings[k].first;
+            }
+        }
+        return -1;
+    };
+
+    // Walk the word with the fewest candidate books and probe the others
+    size_t lead = min_element(wordBookCounts.begin(), wordBookCounts.end()) - wordBookCounts.begin();
+    vector<pair<int, int>> ranked;  // (total distance, bookID)
+    const TermPostings& leadPostings = wordPostings[lead];
+    for (size_t k = 0; k < leadPostings.size(); ++k) {
+        for (int bookID : *leadPostings[k].second) {
+            // Seen already through a closer term of the same word
+            if (distanceFor(leadPostings, k, bookID) >= 0) continue;
+
+            int total = leadPostings[k].first;
+            bool inAll = true;
+            for (size_t i = 0; i < words.size() && inAll; ++i) {
+                if (i == lead) continue;
+                int distance = distanceFor(wordPostings[i], wordPostings[i].size(), bookID);
+                inAll = distance >= 0;
+                total += distance;
+            }
+            if (inAll) ranked.emplace_back(total, bookID);
+        }
+    }
+
+    size_t count = min(limit, ranked.size());
+    partial_sort(ranked.begin(), ranked.begin() + count, ranked.end());
+    results.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (const Book* book = findBook(ranked[i].second)) {
+            results.push_back(book);
+        }
+    }
+    return results;
 }
 
+// Publisher filter compares interned handles, so no strings are touched
+vector<const Book*> Library::getBooksByPublisher(const string& publisher) const {
+    vector<const Book*> results;
+    StringHandle handle;
+    if (!StringPool::global().find(publisher, handle)) return results;
+
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    for (size_t row = 0; row < bookColumns.rowCount(); ++row) {
+        if (bookColumns.isLive(row) && bookColumns.getPublisherHandle(row) == handle) {
+            results.push_back(bookColumns.getBook(row));
+        }
+    }
+    return results;
+}
+
+// Complete the last word of `prefix` from the term trie, most common terms
+// first. Earlier words must match whole index terms and narrow the books
+// counted for each completion.
+vector<Completion> Library::autocomplete(const string& prefix, size_t limit) const {
+    vector<Completion> completions;
+    vector<string> terms = tokenize(prefix);
+    if (terms.empty() || limit == 0) return completions;
+
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    string lead;
+    vector<const vector<int>*> context;
+    for (size_t i = 0; i + 1 < terms.size(); ++i) {
+        auto indexIt = searchIndex.find(terms[i]);
+        if (indexIt == searchIndex.end()) return completions;
+        context.push_back(&indexIt->second);
+        lead += terms[i] + " ";
+    }
+
+    termTrie.visitCompletions(terms.back(), [&](const string& term, uint32_t) {
+        const vector<int>& postings = searchIndex.at(term);
+        Completion completion{lead + term, 0, {}};
+        if (context.empty()) {
+            completion.bookCount = postings.size();
+            size_t shown = min(postings.size(), COMPLETION_BOOK_LIMIT);
+            completion.bookIDs.assign(postings.begin(), postings.begin() + shown);
+            completions.push_back(move(completion));
+            return completions.size() < limit;
+        }
+        for (int bookID : postings) {
+            bool inAll = true;
+            for (size_t i = 0; i < context.size() && inAll; ++i) {
+                inAll = binary_search(context[i]->begin(), context[i]->end(), bookID);
+            }
+            if (!inAll) continue;
+            if (++completion.bookCount <= COMPLETION_BOOK_LIMIT) {
+                completion.bookIDs.push_back(bookID);
+            }
+        }
+        if (completion.bookCount > 0) {
+            completions.push_back(move(completion));
+        }
+        return completions.size() < limit;
+    });
+    return completions;
+}
+
+// Every book in insertion order, read straight from the columns
+vector<const Book*> Library::getAllBooks() const {
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    vector<const Book*> allBooks;
+    allBooks.reserve(bookColumns.size());
+    for (size_t row = 0; row < bookColumns.rowCount(); ++row) {
+        if (bookColumns.isLive(row)) {
+            allBooks.push_back(bookColumns.getBook(row));
+        }
+    }
+    return allBooks;
+}
+
+bool Library::reserveBook(int userID, int bookID) {
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    Book* book = findBook(bookID);
+    if (!book) return false;
+    unique_lock<shared_mutex> bookLock(bookStripe(bookID));
+    if (!applyReserve(book, userID)) return false;
+    logMutation("RESERVE|" + to_string(userID) + "|" + to_string(bookID));
+    return true;
+}
+
+bool Library::cancelReservation(int userID, int bookID) {
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    Book* book = findBook(bookID);
+    if (!book) return false;
+    unique_lock<shared_mutex> bookLock(bookStripe(bookID));
+    if (!applyCancel(book, userID)) return false;
+    logMutation("CANCEL|" + to_string(userID) + "|" + to_string(bookID));
+    return true;
+}
+
+// Answered from the reverse reservation index, so the cost is proportional
+// to the user's number of holds rather than the catalog size
 vector<const Book*> Library::getReservedBooks(int userID) const {
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    vector<int> bookIDs;
+    {
+        shared_lock<shared_mutex> indexLock(reservationIndexMutex);
+        auto it = reservationsByUser.find(userID);
+        if (it != reservationsByUser.end()) {
+            bookIDs.assign(it->second.begin(), it->second.end());
+        }
+    }
+    sort(bookIDs.begin(), bookIDs.end());
+
     vector<const Book*> reservedBooks;
-    for (const auto& pair : books) {
-        if (pair.second->isReservedBy(userID)) {
-            reservedBooks.push_back(pair.second.get());
+    for (int bookID : bookIDs) {
+        if (const Book* book = findBook(bookID)) {
+            reservedBooks.push_back(book);
         }
     }
     return reservedBooks;
 }
 
-void Library::saveState() const {
+// Rewrite only what changed since the last save: whole text files whose
+// contents changed (or that are missing), and individual accounts in the
+// account store. Runs on a read view, so circulation continues meanwhile;
+// changes made during the save are left for the next one.
+bool Library::saveState() const {
+    lock_guard<mutex> viewLock(viewGate);
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    beginView(true);
+    bool saved = writeTextState(*activeView);
+    unique_ptr<ReadView> view = endView();
+    if (!saved) {
+        // Put the changes back so the next save retries them
+        lock_guard<mutex> changeLock(changeMutex);
+        changedFiles |= view->changedFiles;
+        changedAccounts.insert(view->changedAccounts.begin(), view->changedAccounts.end());
+    }
+    return saved;
+}
+
+bool Library::writeTextState(const ReadView& view) const {
+
     // Create data directory if it doesn't exist
     system("mkdir data 2>nul");
     system("mkdir data\\accounts 2>nul");
 
+    auto needsWrite = [&view](uint64_t file, const char* path) {
+        return (view.changedFiles & file) != 0 || !ifstream(path).is_open();
+    };
+
     // Save books
-    ofstream bookFile("data/books.txt");
-    if (!bookFile.is_open()) {
-        cerr << "Error: Could not open books.txt for writing" << endl;
-        return;
-    }
-    
-    for (const auto& pair : books) {
-        const auto& book = pair.second;
-        bookFile << pair.first << "|" << book->getTitle() << "|" << book->getAuthor() 
-                 << "|" << book->getPublisher() << "|" << book->getYear() 
-                 << "|" << book->getISBN() << "|" << book->isAvailable() << "\n";
+    if (needsWrite(CHANGED_BOOKS, "data/books.txt")) {
+        ofstream bookFile("data/books.txt");
+        if (!bookFile.is_open()) {
+            cerr << "Error: Could not open books.txt for writing" << endl;
+            return false;
+        }
+        
+        for (const auto& pair : books) {
+            const auto& book = pair.second;
+            BookImage image = viewBook(*book);
+            bookFile << pair.first << "|" << book->getTitle() << "|" << book->getAuthor() 
+                     << "|" << book->getPublisher() << "|" << book->getYear() 
+                     << "|" << book->getISBN() << "|" << image.availableCopies
+                     << "|" << image.copies << "\n";
+        }
+        bookFile.close();
     }
-    bookFile.close();
-    cout << "Books saved successfully" << endl;
 
-    // Save users by role
-    ofstream studentFile("data/students.txt");
-    ofstream facultyFile("data/faculty.txt");
-    ofstream librarianFile("data/librarians.txt");
+    // Save reservation queues, one line per queued user in queue order
+    if (needsWrite(CHANGED_RESERVATIONS, "data/reservations.txt")) {
+        ofstream reservationFile("data/reservations.txt");
+        if (!reservationFile.is_open()) {
+            cerr << "Error: Could not open reservations.txt for writing" << endl;
+            return false;
+        }
 
-    if (!studentFile.is_open() || !facultyFile.is_open() || !librarianFile.is_open()) {
-        cerr << "Error: Could not open user files for writing" << endl;
-        return;
+        for (const auto& pair : books) {
+            for (int userID : viewBook(*pair.second).reservations) {
+                reservationFile << pair.first << "|" << userID << "\n";
+            }
+        }
+        reservationFile.close();
+    }
+
+    // Save users by role; registered roles share users.txt with a role field.
+    // Only the files holding a changed user are reopened.
+    const char* userPaths[BUILTIN_ROLE_COUNT + 1] = {
+        "data/students.txt", "data/faculty.txt", "data/librarians.txt", "data/users.txt"
+    };
+    ofstream userFiles[BUILTIN_ROLE_COUNT + 1];
+    bool anyUserFile = false;
+    for (RoleID slot = 0; slot <= BUILTIN_ROLE_COUNT; ++slot) {
+        if (!needsWrite(changedUserFile(slot), userPaths[slot])) continue;
+        userFiles[slot].open(userPaths[slot]);
+        if (!userFiles[slot].is_open()) {
+            cerr << "Error: Could not open user files for writing" << endl;
+            return false;
+        }
+        anyUserFile = true;
     }
 
     for (const auto& pair : users) {
+        if (!anyUserFile) break;
         const auto& user = pair.second;
-        string userLine = to_string(pair.first) + "|" + user->getName() + "|" + 
-                         user->getPassword() + "|" + user->getDepartment() + "\n";
-        
-        if (user->getRole() == "Student") {
-            studentFile << userLine;
-        } else if (user->getRole() == "Faculty") {
-            facultyFile << userLine;
-        } else if (user->getRole() == "Librarian") {
-            librarianFile << userLine;
+        RoleID role = user->getRoleID();
+        ofstream& userFile = userFiles[min<RoleID>(role, BUILTIN_ROLE_COUNT)];
+        if (!userFile.is_open()) continue;
+        if (role < BUILTIN_ROLE_COUNT) {
+            userFile << pair.first << "|" << user->getName() << "|"
+                     << user->getPassword() << "|" << user->getDepartment() << "\n";
+        } else {
+            userFile << pair.first << "|" << user->getRole() << "|" << user->getName() << "|"
+                     << user->getPassword() << "|" << user->getDepartment() << "\n";
         }
     }
+    for (auto& userFile : userFiles) {
+        if (userFile.is_open()) userFile.close();
+    }
 
-    studentFile.close();
-    facultyFile.close();
-    librarianFile.close();
+    // Save changed accounts into the consolidated account store
+    if (!view.changedAccounts.empty()) {
+        if (!accountStore.open()) {
+            return false;
+        }
+        for (int userID : view.changedAccounts) {
+            auto accountIt = accounts.find(userID);
+            if (accountIt != accounts.end()) {
+                string payload;
+                viewAccount(*accountIt->second, [&payload](const Account& account) {
+                    payload = serializeAccount(account);
+                });
+                if (!accountStore.write(userID, payload)) {
+                    return false;
+                }
+            } else if (accountStore.contains(userID)) {
+                accountStore.remove(userID);
+            }
+        }
+        if (accountStore.needsCompaction()) {
+            accountStore.compact();
+        }
+    }
+    return true;
+}
 
-    // Save account information
-    for (const auto& pair : accounts) {
-        const auto& account = pair.second;
-        string accountPath = "data/accounts/" + to_string(pair.first) + ".txt";
-        ofstream accountFile(accountPath);
-        
-        if (!accountFile.is_open()) {
-            cerr << "Error: Could not open account file for writing: " << accountPath << endl;
-            continue;
+void Library::markChanged(uint64_t files) {
+    lock_guard<mutex> changeLock(changeMutex);
+    changedFiles |= files;
+}
+
+void Library::markAccountChanged(int userID) {
+    lock_guard<mutex> changeLock(changeMutex);
+    changedAccounts.insert(userID);
+}
+
+void Library::clearChanges() {
+    lock_guard<mutex> changeLock(changeMutex);
+    changedFiles = 0;
+    changedAccounts.clear();
+}
+
+// Open a read view; the caller holds viewGate and the catalog lock shared.
+// Every stripe is held for a moment so no mutation is between its touch and
+// its journal record: the view, the journal sequence and the change set then
+// describe the same point in time. This pauses all circulation, so the view
+// is allocated before the stripes are taken, and with takeChanges the change
+// set is swapped into the view instead of copied.
+void Library::beginView(bool takeChanges) const {
+    auto view = make_unique<ReadView>();
+    for (auto& stripe : bookLocks) stripe.lock();
+    for (auto& stripe : accountLocks) stripe.lock();
+
+    view->journalSequence = journal.getLastSequence();
+    {
+        lock_guard<mutex> changeLock(changeMutex);
+        view->changedFiles = changedFiles;
+        if (takeChanges) {
+            view->changedAccounts.swap(changedAccounts);
+            changedFiles = 0;
+        } else {
+            view->changedAccounts = changedAccounts;
         }
-        
-        // Save current borrows
-        for (const auto& record : account->getCurrentBorrows()) {
-            accountFile << "BORROW|" << record.bookID << "|"
-                       << chrono::system_clock::to_time_t(record.borrowDate) << "|"
-                       << chrono::system_clock::to_time_t(record.dueDate) << "\n";
+    }
+    {
+        lock_guard<mutex> viewLock(viewMutex);
+        activeView = move(view);
+    }
+    viewActive = true;
+
+    for (auto& stripe : accountLocks) stripe.unlock();
+    for (auto& stripe : bookLocks) stripe.unlock();
+}
+
+unique_ptr<Library::ReadView> Library::endView() const {
+    viewActive = false;
+    lock_guard<mutex> viewLock(viewMutex);
+    return move(activeView);
+}
+
+// Touch hooks: called with the entity's stripe held exclusively, before its
+// first change. Only the first change while a view is open copies anything.
+void Library::touchBook(const Book* book) {
+    if (!viewActive.load(memory_order_acquire)) return;
+    lock_guard<mutex> viewLock(viewMutex);
+    if (!activeView || activeView->books.count(book->getBookID())) return;
+    activeView->books.emplace(book->getBookID(),
+        BookImage{book->getCopies(), book->getAvailableCopies(), book->getReservations()});
+}
+
+void Library::touchAccount(const Account* account) {
+    if (!viewActive.load(memory_order_acquire)) return;
+    lock_guard<mutex> viewLock(viewMutex);
+    if (!activeView || activeView->accounts.count(account->getUserID())) return;
+    activeView->accounts.emplace(account->getUserID(), *account);
+}
+
+// Readers: a pre-image if the entity changed since the view began, otherwise
+// the live state, read under the stripe so it cannot change meanwhile
+Library::BookImage Library::viewBook(const Book& book) const {
+    shared_lock<shared_mutex> bookLock(bookStripe(book.getBookID()));
+    {
+        lock_guard<mutex> viewLock(viewMutex);
+        if (activeView) {
+            auto imageIt = activeView->books.find(book.getBookID());
+            if (imageIt != activeView->books.end()) return imageIt->second;
         }
-        
-        // Save borrow history
-        for (const auto& record : account->getBorrowHistory()) {
-            accountFile << "HISTORY|" << record.bookID << "|"
-                       << chrono::system_clock::to_time_t(record.borrowDate) << "|"
-                       << chrono::system_clock::to_time_t(record.dueDate) << "\n";
+    }
+    return BookImage{book.getCopies(), book.getAvailableCopies(), book.getReservations()};
+}
+
+void Library::viewAccount(const Account& account,
+                          const function<void(const Account&)>& reader) const {
+    shared_lock<shared_mutex> accountLock(accountStripe(account.getUserID()));
+    const Account* image = &account;
+    {
+        lock_guard<mutex> viewLock(viewMutex);
+        if (activeView) {
+            auto imageIt = activeView->accounts.find(account.getUserID());
+            if (imageIt != activeView->accounts.end()) image = &imageIt->second;
         }
-        
-        // Save fine
-        accountFile << "FINE|" << account->getTotalFine() << "\n";
-        
-        accountFile.close();
+    }
+    reader(*image);
+}
+
+PoolPtr<User> Library::createUser(RoleID role, int userID, const string& name,
+                                  const string& password) {
+    return makePooled<User>(userPool, userID, name, password, role);
+}
+
+RoleID Library::registerRole(const RolePolicy& policy) {
+    unique_lock<shared_mutex> catalogLock(catalogMutex);
+    RoleID role = RoleRegistry::registerRole(policy);
+    if (role != RoleRegistry::INVALID_ROLE && role >= BUILTIN_ROLE_COUNT) {
+        saveRoles();
+    }
+    return role;
+}
+
+// roles.txt: name|canBorrow|canManageBooks|canManageUsers|maxBooks|maxDays|fineRate
+void Library::loadRoles() {
+    DataParser("data/roles.txt").parseFile([](const DataLine& line) {
+        int maxBooks, maxDays;
+        double fineRate;
+        if (line.size() != 7 || !line.getInt(4, maxBooks) || !line.getInt(5, maxDays) ||
+            !line.getDouble(6, fineRate)) {
+            return false;
+        }
+        string name = line.str(0);
+        RolePolicy policy{name.c_str(), line[1] == "1", line[2] == "1", line[3] == "1",
+                          maxBooks, maxDays, fineRate};
+        return RoleRegistry::registerRole(policy) != RoleRegistry::INVALID_ROLE;
+    });
+}
+
+bool Library::saveRoles() const {
+    ofstream roleFile("data/roles.txt");
+    if (!roleFile.is_open()) {
+        cerr << "Error: Could not open data/roles.txt for writing" << endl;
+        return false;
+    }
+    for (size_t role = BUILTIN_ROLE_COUNT; role < RoleRegistry::size(); ++role) {
+        const RolePolicy& policy = RoleRegistry::get(static_cast<RoleID>(role));
+        roleFile << policy.name << "|" << policy.canBorrow << "|" << policy.canManageBooks << "|"
+                 << policy.canManageUsers << "|" << policy.maxBooks << "|" << policy.maxDays << "|"
+                 << policy.fineRate << "\n";
+    }
+    return true;
+}
+
+// Write a full snapshot from a read view and discard the journal records it
+// covers; records logged while it was being written stay in the journal
+void Library::checkpoint() {
+    lock_guard<mutex> viewLock(viewGate);
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    beginView(false);
+    bool saved = saveSnapshot(SNAPSHOT_PATH);
+    uint64_t sequence = endView()->journalSequence;
+    if (saved) {
+        journal.truncateThrough(sequence);
     }
 }
 
-void Library::loadState() {
+// Queue one mutation record for the journal writer. A due checkpoint is
+// handed to the checkpointer thread, so the mutating thread never waits for
+// a snapshot to be written.
+void Library::logMutation(const string& record) {
+    if (journal.append(record) == 0) return;
+    size_t threshold = (books.size() + accounts.size()) / CHECKPOINT_DIVISOR;
+    if (threshold < CHECKPOINT_INTERVAL) threshold = CHECKPOINT_INTERVAL;
+    if (journal.size() >= threshold) {
+        lock_guard<mutex> checkpointLock(checkpointMutex);
+        if (!checkpointDue) {
+            checkpointDue = true;
+            checkpointWake.notify_one();
+        }
+    }
+}
+
+// Run checkpoints flagged by logMutation until the library is destroyed.
+// The flag is only cleared once a checkpoint finishes, so the mutations
+// logged while it runs do not queue another one straight away; they flag
+// a new one if the journal is still over the threshold afterwards.
+void Library::checkpointLoop() {
+    unique_lock<mutex> checkpointLock(checkpointMutex);
+    while (true) {
+        checkpointWake.wait(checkpointLock, [&] { return checkpointStopping || checkpointDue; });
+        if (checkpointStopping) return;
+        checkpointLock.unlock();
+        checkpoint();
+        checkpointLock.lock();
+        checkpointDue = false;
+    }
+}
+
+void Library::configureJournal(chrono::milliseconds flushInterval, JournalSync policy) {
+    journal.configure(flushInterval, policy);
+}
+
+uint64_t Library::getLastSequence() const { return journal.getLastSequence(); }
+uint64_t Library::getDurableSequence() const { return journal.getDurableSequence(); }
+
+// Block until the journal has written every record up to `sequence`
+bool Library::waitDurable(uint64_t sequence) const {
+    return journal.waitDurable(sequence);
+}
+
+// Re-apply the mutations recorded since the last checkpoint, then reopen the
+// journal for appending. Records that no longer apply (e.g. to a book removed
+// later) are skipped and not counted as replayed.
+void Library::replayJournal() {
+    size_t records = journal.recover();
+    size_t replayed = 0;
+    DataParser parser(journal.getPath());
+    parser.parseFile([this, &replayed](const DataLine& line) {
+        if (line.size() < 2 || line[line.size() - 1] == Journal::TORN_MARKER) return false;
+        string_view type = line[0];
+        int userID;
+        int bookID;
+
+        if (type == "BORROW" && line.size() == 5) {
+            int64_t borrowDate;
+            int64_t dueDate;
+            if (!line.getInt(1, userID) || !line.getInt(2, bookID) ||
+                !line.getInt64(3, borrowDate) || !line.getInt64(4, dueDate)) {
+                return false;
+            }
+            auto bookIt = books.find(bookID);
+            Account* account = findAccount(userID);
+            if (bookIt == books.end() || !account) return true;
+            ++replayed;
+
+            BorrowRecord record;
+            record.bookID = bookID;
+            record.borrowDate = chrono::system_clock::from_time_t(borrowDate);
+            record.dueDate = chrono::system_clock::from_time_t(dueDate);
+            checkOutCopy(bookIt->second.get());
+            account->addBorrow(record);
+            indexLoan(userID, record);
+            markAccountChanged(userID);
+        }
+        else if (type == "RETURN" && line.size() == 4) {
+            double fine;
+            if (!line.getInt(1, userID) || !line.getInt(2, bookID) || !line.getDouble(3, fine)) {
+                return false;
+            }
+            auto bookIt = books.find(bookID);
+            Account* account = findAccount(userID);
+            if (bookIt != books.end() && account) {
+                applyReturn(account, bookIt->second.get(), fine);
+                ++replayed;
+            }
+        }
+        else if ((type == "RESERVE" || type == "CANCEL") && line.size() == 3) {
+            if (!line.getInt(1, userID) || !line.getInt(2, bookID)) return false;
+            auto bookIt = books.find(bookID);
+            if (bookIt == books.end()) return true;
+            bool applied = type == "RESERVE" ? applyReserve(bookIt->second.get(), userID)
+                                             : applyCancel(bookIt->second.get(), userID);
+            if (applied) ++replayed;
+        }
+        else if (type == "PAY" && line.size() == 3) {
+            double amount;
+            if (!line.getInt(1, userID) || !line.getDouble(2, amount)) return false;
+            if (Account* account = findAccount(userID)) {
+                account->payFine(amount);
+                markAccountChanged(userID);
+                ++replayed;
+            }
+        }
+        else if (type == "ADDBOOK" && line.size() >= 6) {
+            int year;
+            if (!line.getInt(1, bookID) || !line.getInt(5, year)) return false;
+            string isbn = line.size() > 6 ? line.str(6) : "";
+            int copies = 1;
+            if (line.size() > 7 && (!line.getInt(7, copies) || copies < 1)) return false;
+            if (insertBook(makePooled<Book>(bookPool, bookID, line.str(2), line.str(3),
+                                            line.str(4), year, isbn, copies))) {
+                ++replayed;
+            }
+        }
+        else if (type == "COPIES" && line.size() == 3) {
+            int copies;
+            if (!line.getInt(1, bookID) || !line.getInt(2, copies)) return false;
+            auto bookIt = books.find(bookID);
+            if (bookIt != books.end() && bookIt->second->setCopies(copies)) {
+                bookColumns.setAvailable(bookID, bookIt->second->isAvailable());
+                markChanged(CHANGED_BOOKS);
+                ++replayed;
+            }
+        }
+        else if (type == "REMOVEBOOK") {
+            if (!line.getInt(1, bookID)) return false;
+            if (eraseBook(bookID)) ++replayed;
+        }
+        else if (type == "ADDUSER" && line.size() >= 5) {
+            RoleID role = RoleRegistry::find(line.str(1));
+            if (role == RoleRegistry::INVALID_ROLE || !line.getInt(2, userID)) return false;
+            auto user = createUser(role, userID, line.str(3), line.str(4));
+            user->setDepartment(line.size() > 5 ? line.str(5) : "");
+            if (insertUser(move(user))) ++replayed;
+        }
+        else if (type == "REMOVEUSER") {
+            if (!line.getInt(1, userID)) return false;
+            if (eraseUser(userID)) ++replayed;
+        }
+        else {
+            return false;
+        }
+        return true;
+    });
+
+    if (replayed > 0) {
+        cout << "Replayed " << replayed << " journal records" << endl;
+    }
+    // Every complete line still occupies a sequence number, applied or not
+    journal.open(records);
+}
+
+// Returns false, leaving the library empty and the journal untouched, if a
+// snapshot exists but cannot be loaded: the journal only holds changes since
+// that snapshot, so falling back to the older text files would lose them.
+bool Library::loadState() {
+    unique_lock<shared_mutex> catalogLock(catalogMutex);
     cout << "Loading state..." << endl;
+
+    // Registered roles must exist before any user that refers to them
+    loadRoles();
+
+    // Nothing read back from disk should be journaled again
+    journal.close();
     
     // Clear existing data
+    searchIndex.clear();
+    termTrie.clear();
+    termGrams.clear();
+    isbnIndex.clear();
+    bookColumns.clear();
+    reservationsByUser.clear();
+    dueIndex.clear();
     books.clear();
     users.clear();
     accounts.clear();
 
-    // Load books
-    cout << "Loading books..." << endl;
-    readDataFile("data/books.txt", [this](const auto& parts) {
-        if (parts.size() == 7) {
-            int id = stoi(parts[0]);
-            int year = stoi(parts[4]);
-            bool available = parts[6] == "1";
-            auto book = make_unique<Book>(id, parts[1], parts[2], parts[3], year, parts[5]);
-            book->setAvailable(available);
-            addBook(move(book));
-            cout << "Loaded book: " << parts[1] << " (ID: " << id << ")" << endl;
+    // Prefer the binary snapshot; the text files are the import format
+    auto start = chrono::steady_clock::now();
+    indexMode = IndexMode::BULK;
+    if (ifstream(SNAPSHOT_PATH).is_open()) {
+        if (!loadSnapshot(SNAPSHOT_PATH)) {
+            indexMode = IndexMode::LIVE;
+            cerr << "Error: Could not load " << SNAPSHOT_PATH << "; not starting, so the changes "
+                 << "in " << journal.getPath() << " since it was written are kept. Restore the "
+                 << "snapshot, or move it away to start from the text files without them." << endl;
+            return false;
         }
-    });
-    cout << "Total books loaded: " << books.size() << endl;
-
-    // Load students
-    cout << "Loading students..." << endl;
-    readDataFile("data/students.txt", [this](const auto& parts) {
-        if (parts.size() == 4) {
-            int id = stoi(parts[0]);
-            auto student = make_unique<Student>(id, parts[1], parts[2]);
-            student->setDepartment(parts[3]);
-            addUser(move(student));
-            loadAccountInfo(id);
-            cout << "Loaded student: " << parts[1] << " (ID: " << id << ")" << endl;
+        finishBulkIndex();
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+            chrono::steady_clock::now() - start).count();
+        cout << "Loaded snapshot: " << books.size() << " books, "
+             << users.size() << " users in " << elapsed << " ms" << endl;
+    } else {
+        importTextState();
+        finishBulkIndex();
+    }
+
+    // Apply everything recorded since the last checkpoint
+    replayJournal();
+    cout << "State loading complete" << endl;
+    return true;
+}
+
+// Load books, users, accounts and reservations from the text data files.
+// Account files are parsed in parallel once every user is known.
+void Library::importTextState() {
+    using Clock = chrono::steady_clock;
+    auto reportPhase = [](const char* phase, size_t count, Clock::time_point start) {
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(Clock::now() - start).count();
+        cout << "Loaded " << count << " " << phase << " in " << elapsed << " ms" << endl;
+    };
+
+    // Load books
+    auto phaseStart = Clock::now();
+    DataParser("data/books.txt").parseFile([this](const DataLine& line) {
+        int id;
+        int year;
+        int onShelf;
+        int copies = 1;
+        if ((line.size() != 7 && line.size() != 8) || !line.getInt(0, id) ||
+            !line.getInt(4, year) || !line.getInt(6, onShelf)) {
+            return false;
         }
+        if (line.size() == 8 && (!line.getInt(7, copies) || copies < 1)) return false;
+        // The available count is informational: availability is recomputed
+        // from the current borrows as the accounts are attached
+        insertBook(makePooled<Book>(bookPool, id, line.str(1), line.str(2), line.str(3), year,
+                                    line.str(5), copies));
+        return true;
     });
+    reportPhase("books", books.size(), phaseStart);
 
-    // Load faculty
-    cout << "Loading faculty..." << endl;
-    readDataFile("data/faculty.txt", [this](const auto& parts) {
-        if (parts.size() == 4) {
-            int id = stoi(parts[0]);
-            auto faculty = make_unique<Faculty>(id, parts[1], parts[2]);
-            faculty->setDepartment(parts[3]);
-            addUser(move(faculty));
-            loadAccountInfo(id);
-            cout << "Loaded faculty: " << parts[1] << " (ID: " << id << ")" << endl;
+    // Load users; their accounts are loaded together afterwards
+    phaseStart = Clock::now();
+    vector<int> userIDs;
+
+    // Load users of the built-in roles, one file per role
+    const pair<const char*, RoleID> userFiles[] = {
+        {"data/students.txt", ROLE_STUDENT},
+        {"data/faculty.txt", ROLE_FACULTY},
+        {"data/librarians.txt", ROLE_LIBRARIAN}
+    };
+    for (const auto& userFile : userFiles) {
+        RoleID role = userFile.second;
+        DataParser parser(userFile.first);
+        parser.parseFile([this, &userIDs, role](const DataLine& line) {
+            int id;
+            if (line.size() != 4 || !line.getInt(0, id)) return false;
+            auto user = createUser(role, id, line.str(1), line.str(2));
+            user->setDepartment(line.str(3));
+            insertUser(move(user));
+            userIDs.push_back(id);
+            return true;
+        });
+    }
+
+    // Load users of registered roles, which carry their role name
+    DataParser("data/users.txt").parseFile([this, &userIDs](const DataLine& line) {
+        int id;
+        if (line.size() != 5 || !line.getInt(0, id)) return false;
+        RoleID role = RoleRegistry::find(line.str(1));
+        if (role == RoleRegistry::INVALID_ROLE) {
+            cerr << "Error: Unknown role " << line[1] << " for user " << id << endl;
+            return true;
         }
+        auto user = createUser(role, id, line.str(2), line.str(3));
+        user->setDepartment(line.str(4));
+        insertUser(move(user));
+        userIDs.push_back(id);
+        return true;
     });
+    reportPhase("users", userIDs.size(), phaseStart);
 
-    // Load librarians
-    cout << "Loading librarians..." << endl;
-    readDataFile("data/librarians.txt", [this](const auto& parts) {
-        if (parts.size() == 4) {
-            int id = stoi(parts[0]);
-            auto librarian = make_unique<Librarian>(id, parts[1], parts[2]);
-            librarian->setDepartment(parts[3]);
-            addUser(move(librarian));
-            loadAccountInfo(id);
-            cout << "Loaded librarian: " << parts[1] << " (ID: " << id << ")" << endl;
+    // The text files now match memory; only accounts that are not yet in the
+    // account store still need saving
+    clearChanges();
+
+    // Load accounts
+    phaseStart = Clock::now();
+    loadAccounts(userIDs);
+    reportPhase("accounts", userIDs.size(), phaseStart);
+
+    // Load reservation queues
+    phaseStart = Clock::now();
+    size_t reservationCount = 0;
+    DataParser reservationParser("data/reservations.txt");
+    reservationParser.parseFile([this, &reservationCount](const DataLine& line) {
+        int bookID;
+        int userID;
+        if (line.size() != 2 || !line.getInt(0, bookID) || !line.getInt(1, userID)) return false;
+        auto bookIt = books.find(bookID);
+        if (bookIt != books.end()) {
+            restoreReservation(bookIt->second.get(), userID);
+            ++reservationCount;
         }
+        return true;
     });
-    cout << "State loading complete" << endl;
+    reportPhase("reservations", reservationCount, phaseStart);
 }
 
 // Helper function to load account information
 void Library::loadAccountInfo(int userID) {
+    unique_lock<shared_mutex> catalogLock(catalogMutex);
+    string payload;
+    if (accountStore.read(userID, payload)) {
+        attachAccount(parseAccount(userID, payload));
+    } else {
+        attachAccount(parseAccountFile(userID));
+    }
+}
+
+// Partition the users into one contiguous shard per core, parse each shard's
+// account files on its own thread, then merge the results on this thread.
+void Library::loadAccounts(const vector<int>& userIDs) {
+    if (userIDs.empty()) return;
+
+    // One sequential read of the account store; users missing from it fall
+    // back to their legacy data/accounts/<id>.txt file
+    const unordered_map<int, string> payloads = accountStore.readAll();
+
+    size_t threadCount = max(1u, thread::hardware_concurrency());
+    threadCount = min(threadCount, userIDs.size());
+    size_t shardSize = (userIDs.size() + threadCount - 1) / threadCount;
+
+    vector<vector<PoolPtr<Account>>> shards(threadCount);
+    vector<exception_ptr> errors(threadCount);
+    vector<thread> workers;
+    for (size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back([this, &userIDs, &payloads, &shards, &errors, t, shardSize] {
+            try {
+                size_t begin = t * shardSize;
+                size_t end = min(begin + shardSize, userIDs.size());
+                for (size_t i = begin; i < end; ++i) {
+                    auto payloadIt = payloads.find(userIDs[i]);
+                    if (payloadIt != payloads.end()) {
+                        shards[t].push_back(parseAccount(userIDs[i], payloadIt->second));
+                    } else {
+                        shards[t].push_back(parseAccountFile(userIDs[i]));
+                    }
+                }
+            } catch (...) {
+                errors[t] = current_exception();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& error : errors) {
+        if (error) rethrow_exception(error);
+    }
+
+    for (auto& shard : shards) {
+        for (auto& account : shard) {
+            if (payloads.find(account->getUserID()) == payloads.end()) {
+                markAccountChanged(account->getUserID());
+            }
+            attachAccount(move(account));
+        }
+    }
+}
+
+// Parse a legacy data/accounts/<userID>.txt file. A missing file yields an
+// empty account.
+PoolPtr<Account> Library::parseAccountFile(int userID) {
     string accountPath = "data/accounts/" + to_string(userID) + ".txt";
     ifstream file(accountPath);
     if (!file.is_open()) {
-        // If file doesn't exist, create a new account
-        accounts[userID] = make_unique<Account>(userID);
-        return;
-    }
-
-    auto account = make_unique<Account>(userID);
-    string line;
-    while (getline(file, line)) {
-        auto parts = split(line, '|');
-        if (parts.size() < 2) continue;
-
-        if (parts[0] == "BORROW") {
-            int bookID = stoi(parts[1]);
-            time_t borrowTime = stoll(parts[2]);
-            time_t dueTime = stoll(parts[3]);
-            
+        return makePooled<Account>(accountPool, userID);
+    }
+    stringstream contents;
+    contents << file.rdbuf();
+    return parseAccount(userID, contents.str());
+}
+
+// Parse BORROW/HISTORY/FINE lines into an account. Touches no Library state,
+// so loader threads can call it concurrently.
+PoolPtr<Account> Library::parseAccount(int userID, const string& text) {
+    auto account = makePooled<Account>(accountPool, userID);
+    DataParser parser("account " + to_string(userID));
+    parser.parseText(text, [&account](const DataLine& line) {
+        if ((line[0] == "BORROW" || line[0] == "HISTORY") && line.size() == 4) {
             BorrowRecord record;
-            record.bookID = bookID;
-            record.borrowDate = chrono::system_clock::from_time_t(borrowTime);
-            record.dueDate = chrono::system_clock::from_time_t(dueTime);
-            
-            account->addBorrow(bookID);
-            
-            // Update book availability only for current borrows
-            if (auto book = const_cast<Book*>(getBook(bookID))) {
-                book->setAvailable(false);
+            int64_t borrowDate;
+            int64_t dueDate;
+            if (!line.getInt(1, record.bookID) || !line.getInt64(2, borrowDate) ||
+                !line.getInt64(3, dueDate)) {
+                return false;
             }
+            record.borrowDate = chrono::system_clock::from_time_t(borrowDate);
+            record.dueDate = chrono::system_clock::from_time_t(dueDate);
+
+            if (line[0] == "BORROW") {
+                account->addBorrow(record);
+            } else {
+                account->addToBorrowHistory(record);
+            }
+            return true;
         }
-        else if (parts[0] == "HISTORY") {
-            int bookID = stoi(parts[1]);
-            time_t borrowTime = stoll(parts[2]);
-            time_t dueTime = stoll(parts[3]);
-            
-            BorrowRecord record;
-            record.bookID = bookID;
-            record.borrowDate = chrono::system_clock::from_time_t(borrowTime);
-            record.dueDate = chrono::system_clock::from_time_t(dueTime);
-            
-            account->addToBorrowHistory(record);
-            // Don't update book availability for history records
-        }
-        else if (parts[0] == "FINE") {
-            double fine = stod(parts[1]);
+        if (line[0] == "FINE" && line.size() == 2) {
+            double fine;
+            if (!line.getDouble(1, fine)) return false;
             account->addFine(fine);
+            return true;
         }
+        return false;
+    });
+    return account;
+}
+
+// Serialize an account in the same line format parseAccount reads
+string Library::serializeAccount(const Account& account) {
+    ostringstream out;
+    
+    // Save current borrows
+    for (const auto& record : account.getCurrentBorrows()) {
+        out << "BORROW|" << record.bookID << "|"
+            << chrono::system_clock::to_time_t(record.borrowDate) << "|"
+            << chrono::system_clock::to_time_t(record.dueDate) << "\n";
+    }
+    
+    // Save borrow history
+    for (const auto& record : account.getBorrowHistory()) {
+        out << "HISTORY|" << record.bookID << "|"
+            << chrono::system_clock::to_time_t(record.borrowDate) << "|"
+            << chrono::system_clock::to_time_t(record.dueDate) << "\n";
     }
     
+    // Save fine
+    out << "FINE|" << account.getTotalFine() << "\n";
+    return out.str();
+}
+
+// Install a parsed account, mark its current borrows as checked out and
+// index their due dates in place of any account it replaces
+void Library::attachAccount(PoolPtr<Account> account) {
+    int userID = account->getUserID();
+    auto accountIt = accounts.find(userID);
+    if (accountIt != accounts.end()) {
+        for (const auto& record : accountIt->second->getCurrentBorrows()) {
+            unindexLoan(userID, record);
+        }
+    }
+    for (const auto& record : account->getCurrentBorrows()) {
+        auto bookIt = books.find(record.bookID);
+        if (bookIt != books.end()) {
+            checkOutCopy(bookIt->second.get());
+        }
+        indexLoan(userID, record);
+    }
     accounts[userID] = move(account);
-    file.close();
 }
 
+// Point-in-time list of every loan, read through a read view so borrows and
+// returns made while it runs do not show up half-applied
 vector<BorrowInfo> Library::getAllBorrowedBooks() const {
+    lock_guard<mutex> viewLock(viewGate);
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
     vector<BorrowInfo> borrowedBooks;
+    beginView(false);
     
     for (const auto& pair : accounts) {
-        const User* user = getUser(pair.first);  // pair.first is userId
+        const User* user = findUser(pair.first);  // pair.first is userId
         if (!user) continue;
         
-        for (const auto& borrow : pair.second->getCurrentBorrows()) {
-            const Book* book = getBook(borrow.bookID);
-            if (!book) continue;
-            
-            borrowedBooks.push_back({
-                book,
-                user,
-                borrow.borrowDate,
-                borrow.dueDate
-            });
-        }
+        viewAccount(*pair.second, [&](const Account& account) {
+            for (const auto& borrow : account.getCurrentBorrows()) {
+                const Book* book = findBook(borrow.bookID);
+                if (!book) continue;
+                
+                borrowedBooks.push_back({
+                    book,
+                    user,
+                    borrow.borrowDate,
+                    borrow.dueDate
+                });
+            }
+        });
     }
+    endView();
     return borrowedBooks;
-}
\ No newline at end of file
+}
+
+// Walk the due-date index in order, starting after `after` when given and
+// stopping at the first loan due at or after `until`. Entries are copied out
+// in small batches so the index lock is never held while the visitor runs.
+// The caller holds the catalog lock. Returns false if the visitor stopped.
+bool Library::visitLoans(const DueEntry* after, chrono::system_clock::time_point until,
+                         const function<bool(const DueEntry&, const BorrowInfo&)>& visitor) const {
+    static const size_t BATCH_SIZE = 256;
+    vector<DueEntry> batch;
+    bool resume = after != nullptr;
+    DueEntry last = after ? *after : DueEntry{};
+
+    while (true) {
+        batch.clear();
+        {
+            lock_guard<mutex> indexLock(dueIndexMutex);
+            auto it = resume ? dueIndex.upper_bound(last) : dueIndex.begin();
+            for (; it != dueIndex.end() && it->dueDate < until && batch.size() < BATCH_SIZE; ++it) {
+                batch.push_back(*it);
+            }
+        }
+        if (batch.empty()) return true;
+
+        for (const auto& entry : batch) {
+            const Book* book = findBook(entry.bookID);
+            const User* user = findUser(entry.userID);
+            if (!book || !user) continue;
+            if (!visitor(entry, {book, user, entry.borrowDate, entry.dueDate})) return false;
+        }
+        last = batch.back();
+        resume = true;
+    }
+}
+
+size_t Library::forEachOverdue(chrono::system_clock::time_point now,
+                               const function<bool(const BorrowInfo&)>& visitor) const {
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    size_t visited = 0;
+    visitLoans(nullptr, now, [&visited, &visitor](const DueEntry&, const BorrowInfo& info) {
+        ++visited;
+        return visitor(info);
+    });
+    return visited;
+}
+
+vector<BorrowInfo> Library::getOverdueBooks(chrono::system_clock::time_point now, size_t limit) const {
+    vector<BorrowInfo> overdue;
+    forEachOverdue(now, [&overdue, limit](const BorrowInfo& info) {
+        overdue.push_back(info);
+        return limit == 0 || overdue.size() < limit;
+    });
+    return overdue;
+}
+
+// Resume tokens are the due-date index key of the last loan on the previous
+// page: "<due date ticks>.<userID>.<bookID>"
+static string makeLoanToken(chrono::system_clock::time_point dueDate, int userID, int bookID) {
+    return to_string(dueDate.time_since_epoch().count()) + "." + to_string(userID) + "." +
+           to_string(bookID);
+}
+
+bool Library::getBorrowedBooksPage(const LoanQuery& query, LoanPage& page) const {
+    page.loans.clear();
+    page.nextToken.clear();
+
+    DueEntry after{};
+    if (!query.resumeToken.empty()) {
+        bool valid = false;
+        DataParser("resume token", '.').parseText(query.resumeToken, [&](const DataLine& line) {
+            int64_t ticks;
+            valid = line.size() == 3 && line.getInt64(0, ticks) &&
+                    line.getInt(1, after.userID) && line.getInt(2, after.bookID);
+            if (valid) {
+                after.dueDate = chrono::system_clock::time_point(chrono::system_clock::duration(ticks));
+            }
+            return valid;
+        });
+        if (!valid) return false;
+    }
+
+    // Departments are interned, so the filter compares handles
+    StringHandle department = 0;
+    if (!query.department.empty() && !StringPool::global().find(query.department, department)) {
+        return true;
+    }
+
+    size_t pageSize = max<size_t>(query.pageSize, 1);
+    page.loans.reserve(pageSize);
+    shared_lock<shared_mutex> catalogLock(catalogMutex);
+    visitLoans(query.resumeToken.empty() ? nullptr : &after,
+               chrono::system_clock::time_point::max(),
+               [&](const DueEntry&, const BorrowInfo& info) {
+        if (!query.role.empty() && info.borrower->getRole() != query.role) return true;
+        if (!query.department.empty() && info.borrower->getDepartmentHandle() != department) {
+            return true;
+        }
+        if (page.loans.size() == pageSize) {
+            // A further match exists, so point the token at the last loan returned
+            const BorrowInfo& lastLoan = page.loans.back();
+            page.nextToken = makeLoanToken(lastLoan.dueDate, lastLoan.borrower->getUserID(),
+                                           lastLoan.book->getBookID());
+            return false;
+        }
+        page.loans.push_back(info);
+        return true;
+    });
+    return true;
+}
@@ -0,0 +1,67 @@
+#include "../header/ObjectPool.h"
+#include <algorithm>
+
+using namespace std;
+
+// SlabAllocator Implementation
+const size_t SlabAllocator::FIRST_SLAB_SLOTS;
+const size_t SlabAllocator::MAX_SLAB_SLOTS;
+
+SlabAllocator::SlabAllocator(size_t objectSize)
+    : currentSlab(0), nextSlot(0), freeList(nullptr), liveCount(0) {
+    // Every slot must hold a free-list link and keep the next slot aligned
+    size_t alignment = alignof(max_align_t);
+    slotSize = max(objectSize, sizeof(FreeSlot));
+    slotSize = (slotSize + alignment - 1) / alignment * alignment;
+}
+
+void* SlabAllocator::allocate() {
+    lock_guard<mutex> lock(poolMutex);
+    ++liveCount;
+    if (freeList) {
+        FreeSlot* slot = freeList;
+        freeList = slot->next;
+        return slot;
+    }
+
+    // Move on to the next slab (allocating it if needed) once this one is used up
+    if (slabs.empty() || nextSlot == slabSlots[currentSlab]) {
+        if (!slabs.empty()) ++currentSlab;
+        if (currentSlab == slabs.size()) {
+            size_t slots = slabs.empty() ? FIRST_SLAB_SLOTS
+                                         : min(slabSlots.back() * 2, MAX_SLAB_SLOTS);
+            slabs.emplace_back(new unsigned char[slots * slotSize]);
+            slabSlots.push_back(slots);
+        }
+        nextSlot = 0;
+    }
+    return slabs[currentSlab].get() + slotSize * nextSlot++;
+}
+
+void SlabAllocator::deallocate(void* slot) {
+    lock_guard<mutex> lock(poolMutex);
+    if (--liveCount == 0) {
+        // Everything is free: rewind instead of threading a free list
+        currentSlab = 0;
+        nextSlot = 0;
+        freeList = nullptr;
+        return;
+    }
+    FreeSlot* freed = static_cast<FreeSlot*>(slot);
+    freed->next = freeList;
+    freeList = freed;
+}
+
+size_t SlabAllocator::getSlotSize() const { return slotSize; }
+
+size_t SlabAllocator::size() const {
+    lock_guard<mutex> lock(poolMutex);
+    return liveCount;
+}
+
+size_t SlabAllocator::capacity() const {
+    lock_guard<mutex> lock(poolMutex);
+    size_t slots = 0;
+    for (size_t count : slabSlots) slots += count;
+    return slots;
+}
@@ -0,0 +1,146 @@
+#include "../header/PrefixTrie.h"
+#include <algorithm>
+#include <queue>
+
+using namespace std;
+
+// PrefixTrie Implementation
+PrefixTrie::PrefixTrie() : termCount(0) {}
+
+// Index of the child whose label starts with `first`, or of the position
+// where it would be inserted
+size_t PrefixTrie::findChild(const Node& node, char first) {
+    auto it = lower_bound(node.children.begin(), node.children.end(), first,
+        [](const unique_ptr<Node>& child, char c) { return child->label[0] < c; });
+    return it - node.children.begin();
+}
+
+void PrefixTrie::refresh(Node& node) {
+    node.maxWeight = node.weight;
+    for (const auto& child : node.children) {
+        node.maxWeight = max(node.maxWeight, child->maxWeight);
+    }
+}
+
+void PrefixTrie::setWeight(const string& term, uint32_t weight) {
+    if (term.empty()) return;
+
+    // Descend to the term's node, adding a leaf or splitting an edge where
+    // the term leaves the existing labels
+    vector<Node*> path{&root};
+    Node* node = &root;
+    size_t pos = 0;
+    while (pos < term.size()) {
+        size_t index = findChild(*node, term[pos]);
+        bool found = index < node->children.size() && node->children[index]->label[0] == term[pos];
+        if (!found) {
+            if (weight == 0) return;
+            auto leaf = make_unique<Node>();
+            leaf->label = term.substr(pos);
+            node->children.insert(node->children.begin() + index, move(leaf));
+            node = node->children[index].get();
+            path.push_back(node);
+            break;
+        }
+
+        Node* child = node->children[index].get();
+        size_t common = 0;
+        while (common < child->label.size() && pos + common < term.size() &&
+               child->label[common] == term[pos + common]) {
+            ++common;
+        }
+        if (common < child->label.size()) {
+            if (weight == 0) return;
+            auto middle = make_unique<Node>();
+            middle->label = child->label.substr(0, common);
+            child->label.erase(0, common);
+            middle->children.push_back(move(node->children[index]));
+            refresh(*middle);
+            node->children[index] = move(middle);
+            child = node->children[index].get();
+        }
+        node = child;
+        path.push_back(node);
+        pos += common;
+    }
+
+    if (node->weight == 0 && weight > 0) ++termCount;
+    if (node->weight > 0 && weight == 0) --termCount;
+    node->weight = weight;
+
+    // Walk back up: drop empty leaves, merge pass-through nodes into their
+    // only child and refresh the cached subtree maxima
+    for (size_t i = path.size() - 1; i > 0; --i) {
+        Node* current = path[i];
+        Node* parent = path[i - 1];
+        if (current->weight == 0 && current->children.empty()) {
+            parent->children.erase(parent->children.begin() + findChild(*parent, current->label[0]));
+            continue;
+        }
+        if (current->weight == 0 && current->children.size() == 1) {
+            unique_ptr<Node> only = move(current->children[0]);
+            current->label += only->label;
+            current->weight = only->weight;
+            current->children = move(only->children);
+        }
+        refresh(*current);
+    }
+    refresh(root);
+}
+
+void PrefixTrie::clear() {
+    root.children.clear();
+    root.maxWeight = 0;
+    termCount = 0;
+}
+
+size_t PrefixTrie::size() const { return termCount; }
+
+void PrefixTrie::visitCompletions(const string& prefix,
+                                  const function<bool(const string&, uint32_t)>& visitor) const {
+    // Find the node covering the prefix, which may end partway along an edge
+    const Node* node = &root;
+    string text;
+    size_t pos = 0;
+    while (pos < prefix.size()) {
+        size_t index = findChild(*node, prefix[pos]);
+        if (index == node->children.size() || node->children[index]->label[0] != prefix[pos]) return;
+        const Node* child = node->children[index].get();
+        size_t length = min(child->label.size(), prefix.size() - pos);
+        if (child->label.compare(0, length, prefix, pos, length) != 0) return;
+        text += child->label;
+        node = child;
+        pos += length;
+    }
+
+    // Best-first expansion: a subtree is queued under its cached maximum and
+    // a term under its own weight, so terms come out heaviest first
+    struct Entry {
+        uint32_t weight;
+        bool term;
+        const Node* node;
+        string text;
+
+        bool operator<(const Entry& other) const {
+            if (weight != other.weight) return weight < other.weight;
+            if (term != other.term) return !term;
+            return text > other.text;
+        }
+    };
+    priority_queue<Entry> frontier;
+    frontier.push({node->maxWeight, false, node, text});
+    while (!frontier.empty()) {
+        Entry entry = frontier.top();
+        frontier.pop();
+        if (entry.term) {
+            if (!visitor(entry.text, entry.weight)) return;
+            continue;
+        }
+        if (entry.node->weight > 0) {
+            frontier.push({entry.node->weight, true, entry.node, entry.text});
+        }
+        for (const auto& child : entry.node->children) {
+            frontier.push({child->maxWeight, false, child.get(), entry.text + child->label});
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#include "../header/RolePolicy.h"
+#include "../header/StringPool.h"
+#include <iostream>
+
+using namespace std;
+
+// RoleRegistry Implementation
+const size_t RoleRegistry::MAX_ROLES;
+const RoleID RoleRegistry::INVALID_ROLE;
+
+RolePolicy RoleRegistry::table[MAX_ROLES] = {
+    BUILTIN_ROLES[ROLE_STUDENT],
+    BUILTIN_ROLES[ROLE_FACULTY],
+    BUILTIN_ROLES[ROLE_LIBRARIAN]
+};
+atomic<size_t> RoleRegistry::count{BUILTIN_ROLE_COUNT};
+mutex RoleRegistry::registerMutex;
+
+RoleID RoleRegistry::find(const string& name) {
+    size_t roles = size();
+    for (size_t role = 0; role < roles; ++role) {
+        if (name == table[role].name) return static_cast<RoleID>(role);
+    }
+    return INVALID_ROLE;
+}
+
+// Add a role, or return the existing ID if the same role is registered
+// again. Policies are read without locking and so never change: a different
+// policy under an existing name is rejected. The name is interned so the
+// table can keep a plain pointer to it.
+RoleID RoleRegistry::registerRole(const RolePolicy& policy) {
+    lock_guard<mutex> lock(registerMutex);
+    RoleID existing = find(policy.name);
+    if (existing != INVALID_ROLE) {
+        const RolePolicy& current = table[existing];
+        if (current.canBorrow == policy.canBorrow && current.canManageBooks == policy.canManageBooks &&
+            current.canManageUsers == policy.canManageUsers && current.maxBooks == policy.maxBooks &&
+            current.maxDays == policy.maxDays && current.fineRate == policy.fineRate) {
+            return existing;
+        }
+        cerr << "Error: Role " << policy.name << " already exists with a different policy" << endl;
+        return INVALID_ROLE;
+    }
+
+    size_t role = count.load(memory_order_relaxed);
+    if (role >= MAX_ROLES) {
+        cerr << "Error: Role table is full, cannot register " << policy.name << endl;
+        return INVALID_ROLE;
+    }
+    table[role] = policy;
+    StringPool& pool = StringPool::global();
+    table[role].name = pool.get(pool.intern(policy.name)).c_str();
+    count.store(role + 1, memory_order_release);
+    return static_cast<RoleID>(role);
+}
@@ -0,0 +1,449 @@
+#include "../header/LibrarySystem.h"
+#include "../header/Snapshot.h"
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// MappedFile
+// Read-only view of a whole file. Uses mmap where available so loading a
+// snapshot does not copy it through a read buffer first.
+class MappedFile {
+private:
+    const char* data;
+    size_t length;
+#ifdef _WIN32
+    vector<char> buffer;
+#endif
+
+public:
+    explicit MappedFile(const string& path) : data(nullptr), length(0) {
+#ifdef _WIN32
+        ifstream file(path, ios::binary);
+        if (!file.is_open()) return;
+        buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        data = buffer.data();
+        length = buffer.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<const char*>(mapped);
+                length = info.st_size;
+            }
+        }
+        ::close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (data) munmap(const_cast<char*>(data), length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return data; }
+    size_t size() const { return length; }
+};
+
+// Bytes a section of `count` records takes up, padding included
+static uint64_t sectionSize(uint64_t count, size_t recordSize) {
+    uint64_t bytes = count * recordSize;
+    return (bytes + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+template<typename Record>
+static bool writeSection(FILE* out, const vector<Record>& records) {
+    static const char padding[SNAPSHOT_ALIGNMENT] = {};
+    size_t bytes = records.size() * sizeof(Record);
+    size_t paddingBytes = sectionSize(records.size(), sizeof(Record)) - bytes;
+    return (bytes == 0 || fwrite(records.data(), 1, bytes, out) == bytes) &&
+           fwrite(padding, 1, paddingBytes, out) == paddingBytes;
+}
+
+static int64_t toSnapshotTime(chrono::system_clock::time_point time) {
+    return static_cast<int64_t>(chrono::system_clock::to_time_t(time));
+}
+
+static chrono::system_clock::time_point fromSnapshotTime(int64_t time) {
+    return chrono::system_clock::from_time_t(static_cast<time_t>(time));
+}
+
+// Write every book, user and account as of the open read view
+bool Library::saveSnapshot(const string& path) const {
+    const ReadView& view = *activeView;
+    vector<SnapshotBook> bookRecords;
+    vector<SnapshotUser> userRecords;
+    vector<SnapshotAccount> accountRecords;
+    vector<SnapshotBorrow> borrowRecords;
+    vector<SnapshotReservation> reservationRecords;
+    vector<SnapshotTerm> termRecords;
+    vector<int32_t> postingRecords;
+    vector<SnapshotString> roleRecords;
+    vector<int32_t> changedAccountRecords;
+    string heap;
+
+    auto addString = [&heap](const string& value) {
+        SnapshotString ref{};
+        ref.offset = heap.size();
+        ref.length = static_cast<uint32_t>(value.size());
+        heap += value;
+        return ref;
+    };
+
+    // Interned fields are written to the heap once per distinct value
+    unordered_map<StringHandle, SnapshotString> internedRefs;
+    auto addInterned = [&](StringHandle handle) {
+        auto it = internedRefs.find(handle);
+        if (it != internedRefs.end()) return it->second;
+        SnapshotString ref = addString(StringPool::global().get(handle));
+        internedRefs.emplace(handle, ref);
+        return ref;
+    };
+
+    bookRecords.reserve(books.size());
+    for (const auto& pair : books) {
+        const Book& book = *pair.second;
+        SnapshotBook record{};
+        record.bookID = pair.first;
+        record.year = book.getYear();
+        BookImage image = viewBook(book);
+        record.copies = static_cast<uint32_t>(image.copies);
+        record.title = addString(book.getTitle());
+        record.author = addInterned(book.getAuthorHandle());
+        record.publisher = addInterned(book.getPublisherHandle());
+        record.isbn = addString(book.getISBN());
+        bookRecords.push_back(record);
+
+        for (int userID : image.reservations) {
+            reservationRecords.push_back({pair.first, userID});
+        }
+    }
+
+    userRecords.reserve(users.size());
+    for (const auto& pair : users) {
+        const User& user = *pair.second;
+        SnapshotUser record{};
+        record.userID = pair.first;
+        record.role = user.getRoleID();
+        record.name = addString(user.getName());
+        record.password = addString(user.getPassword());
+        record.department = addInterned(user.getDepartmentHandle());
+        userRecords.push_back(record);
+    }
+
+    accountRecords.reserve(accounts.size());
+    for (const auto& pair : accounts) {
+        viewAccount(*pair.second, [&](const Account& account) {
+            SnapshotAccount record{};
+            record.userID = pair.first;
+            record.currentCount = static_cast<uint32_t>(account.getCurrentBorrows().size());
+            record.historyCount = static_cast<uint32_t>(account.getBorrowHistory().size());
+            record.totalFine = account.getTotalFine();
+            accountRecords.push_back(record);
+
+            for (const auto* records : {&account.getCurrentBorrows(), &account.getBorrowHistory()}) {
+                for (const auto& borrow : *records) {
+                    SnapshotBorrow entry{};
+                    entry.bookID = borrow.bookID;
+                    entry.borrowDate = toSnapshotTime(borrow.borrowDate);
+                    entry.dueDate = toSnapshotTime(borrow.dueDate);
+                    borrowRecords.push_back(entry);
+                }
+            }
+        });
+    }
+
+    // The search index is derived from the books, but storing it spares the
+    // load from tokenizing every title again
+    termRecords.reserve(searchIndex.size());
+    for (const auto& entry : searchIndex) {
+        SnapshotTerm record{};
+        record.term = addString(entry.first);
+        record.postingCount = static_cast<uint32_t>(entry.second.size());
+        termRecords.push_back(record);
+        postingRecords.insert(postingRecords.end(), entry.second.begin(), entry.second.end());
+    }
+
+    // Registered roles are numbered in registration order, so record which
+    // role each stored RoleID meant
+    for (size_t role = 0; role < RoleRegistry::size(); ++role) {
+        roleRecords.push_back(addString(RoleRegistry::get(static_cast<RoleID>(role)).name));
+    }
+
+    changedAccountRecords.assign(view.changedAccounts.begin(), view.changedAccounts.end());
+
+    SnapshotHeader header{};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.bookCount = bookRecords.size();
+    header.userCount = userRecords.size();
+    header.accountCount = accountRecords.size();
+    header.borrowCount = borrowRecords.size();
+    header.reservationCount = reservationRecords.size();
+    header.termCount = termRecords.size();
+    header.postingCount = postingRecords.size();
+    header.roleCount = roleRecords.size();
+    header.changedAccountCount = changedAccountRecords.size();
+    header.changedFiles = view.changedFiles;
+    header.stringHeapSize = heap.size();
+
+    // Write to a temporary file, sync it and rename it over the old snapshot
+    // so a crash never leaves a truncated snapshot behind. The directory is
+    // synced too before returning: the caller then drops the journal records
+    // the snapshot covers, so the snapshot must be on disk first.
+    string tempPath = path + ".tmp";
+    FILE* out = fopen(tempPath.c_str(), "wb");
+    if (!out) {
+        cerr << "Error: Could not open snapshot for writing: " << tempPath << endl;
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, out) == 1 &&
+                   writeSection(out, bookRecords) &&
+                   writeSection(out, userRecords) &&
+                   writeSection(out, accountRecords) &&
+                   writeSection(out, borrowRecords) &&
+                   writeSection(out, reservationRecords) &&
+                   writeSection(out, termRecords) &&
+                   writeSection(out, postingRecords) &&
+                   writeSection(out, roleRecords) &&
+                   writeSection(out, changedAccountRecords) &&
+                   fwrite(heap.data(), 1, heap.size(), out) == heap.size() &&
+                   Journal::syncFile(out);
+    written = fclose(out) == 0 && written;
+    if (!written) {
+        cerr << "Error: Failed to write snapshot: " << tempPath << endl;
+        return false;
+    }
+
+#ifdef _WIN32
+    remove(path.c_str());
+#endif
+    if (rename(tempPath.c_str(), path.c_str()) != 0) {
+        cerr << "Error: Could not replace snapshot: " << path << endl;
+        return false;
+    }
+    if (!Journal::syncDirectory(path)) {
+        cerr << "Error: Could not sync the snapshot directory: " << path << endl;
+        return false;
+    }
+    return true;
+}
+
+// Rebuild books, users and accounts from a snapshot. Returns false, leaving
+// the library empty, if the snapshot is missing or malformed.
+bool Library::loadSnapshot(const string& path) {
+    MappedFile file(path);
+    if (!file.begin()) return false;
+
+    const char* base = file.begin();
+    size_t size = file.size();
+    if (size < sizeof(SnapshotHeader)) {
+        cerr << "Error: Snapshot is truncated: " << path << endl;
+        return false;
+    }
+
+    SnapshotHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION) {
+        cerr << "Error: Unsupported snapshot format: " << path << endl;
+        return false;
+    }
+    if (header.byteOrder != SNAPSHOT_BYTE_ORDER) {
+        cerr << "Error: Snapshot was written with a different byte order: " << path << endl;
+        return false;
+    }
+
+    // Bound every count by the file size first, so the sum cannot wrap
+    bool countsFit = true;
+    for (uint64_t count : {header.bookCount, header.userCount, header.accountCount,
+                           header.borrowCount, header.reservationCount, header.termCount,
+                           header.postingCount, header.roleCount, header.changedAccountCount,
+                           header.stringHeapSize}) {
+        countsFit = countsFit && count <= size;
+    }
+    uint64_t expectedSize = sizeof(SnapshotHeader) +
+                            sectionSize(header.bookCount, sizeof(SnapshotBook)) +
+                            sectionSize(header.userCount, sizeof(SnapshotUser)) +
+                            sectionSize(header.accountCount, sizeof(SnapshotAccount)) +
+                            sectionSize(header.borrowCount, sizeof(SnapshotBorrow)) +
+                            sectionSize(header.reservationCount, sizeof(SnapshotReservation)) +
+                            sectionSize(header.termCount, sizeof(SnapshotTerm)) +
+                            sectionSize(header.postingCount, sizeof(int32_t)) +
+                            sectionSize(header.roleCount, sizeof(SnapshotString)) +
+                            sectionSize(header.changedAccountCount, sizeof(int32_t)) +
+                            header.stringHeapSize;
+    if (!countsFit || expectedSize != size) {
+        cerr << "Error: Snapshot size does not match its header: " << path << endl;
+        return false;
+    }
+
+    const char* cursor = base + sizeof(SnapshotHeader);
+    auto bookRecords = reinterpret_cast<const SnapshotBook*>(cursor);
+    cursor += sectionSize(header.bookCount, sizeof(SnapshotBook));
+    auto userRecords = reinterpret_cast<const SnapshotUser*>(cursor);
+    cursor += sectionSize(header.userCount, sizeof(SnapshotUser));
+    auto accountRecords = reinterpret_cast<const SnapshotAccount*>(cursor);
+    cursor += sectionSize(header.accountCount, sizeof(SnapshotAccount));
+    auto borrowRecords = reinterpret_cast<const SnapshotBorrow*>(cursor);
+    cursor += sectionSize(header.borrowCount, sizeof(SnapshotBorrow));
+    auto reservationRecords = reinterpret_cast<const SnapshotReservation*>(cursor);
+    cursor += sectionSize(header.reservationCount, sizeof(SnapshotReservation));
+    auto termRecords = reinterpret_cast<const SnapshotTerm*>(cursor);
+    cursor += sectionSize(header.termCount, sizeof(SnapshotTerm));
+    auto postingRecords = reinterpret_cast<const int32_t*>(cursor);
+    cursor += sectionSize(header.postingCount, sizeof(int32_t));
+    auto roleRecords = reinterpret_cast<const SnapshotString*>(cursor);
+    cursor += sectionSize(header.roleCount, sizeof(SnapshotString));
+    auto changedAccountRecords = reinterpret_cast<const int32_t*>(cursor);
+    cursor += sectionSize(header.changedAccountCount, sizeof(int32_t));
+    const char* heap = cursor;
+
+    bool valid = true;
+    auto getString = [&](const SnapshotString& ref) {
+        if (ref.offset > header.stringHeapSize || ref.length > header.stringHeapSize - ref.offset) {
+            valid = false;
+            return string();
+        }
+        return string(heap + ref.offset, ref.length);
+    };
+
+    // Terms first, so inserting the books below only has to index ISBNs
+    uint64_t nextPosting = 0;
+    for (uint64_t i = 0; i < header.termCount && valid; ++i) {
+        const SnapshotTerm& record = termRecords[i];
+        if (record.postingCount == 0 || nextPosting + record.postingCount > header.postingCount) {
+            valid = false;
+            break;
+        }
+        vector<int>& postings = searchIndex[getString(record.term)];
+        postings.assign(postingRecords + nextPosting,
+                        postingRecords + nextPosting + record.postingCount);
+        nextPosting += record.postingCount;
+    }
+    valid = valid && nextPosting == header.postingCount && searchIndex.size() == header.termCount;
+    indexMode = IndexMode::PRELOADED;
+
+    for (uint64_t i = 0; i < header.bookCount && valid; ++i) {
+        const SnapshotBook& record = bookRecords[i];
+        if (record.copies < 1 || record.copies > INT32_MAX) {
+            valid = false;
+            continue;
+        }
+        insertBook(makePooled<Book>(bookPool, record.bookID, getString(record.title),
+                                    getString(record.author), getString(record.publisher),
+                                    record.year, getString(record.isbn),
+                                    static_cast<int>(record.copies)));
+    }
+
+    // Every stored posting must be a loaded book, in increasing order
+    for (auto indexIt = searchIndex.begin(); indexIt != searchIndex.end() && valid; ++indexIt) {
+        const vector<int>& postings = indexIt->second;
+        for (size_t j = 0; j < postings.size() && valid; ++j) {
+            valid = (j == 0 || postings[j - 1] < postings[j]) && books.count(postings[j]);
+        }
+    }
+
+    // Map the stored RoleIDs to this process's by role name
+    vector<RoleID> roleMap;
+    for (uint64_t i = 0; i < header.roleCount && valid; ++i) {
+        string roleName = getString(roleRecords[i]);
+        RoleID role = RoleRegistry::find(roleName);
+        if (role == RoleRegistry::INVALID_ROLE) {
+            cerr << "Error: Snapshot refers to unknown role " << roleName << endl;
+            valid = false;
+        }
+        roleMap.push_back(role);
+    }
+
+    for (uint64_t i = 0; i < header.userCount && valid; ++i) {
+        const SnapshotUser& record = userRecords[i];
+        string name = getString(record.name);
+        string password = getString(record.password);
+        RoleID role = record.role < roleMap.size() ? roleMap[record.role] : RoleRegistry::INVALID_ROLE;
+        if (!RoleRegistry::isValid(role)) {
+            valid = false;
+            continue;
+        }
+        auto user = createUser(role, record.userID, name, password);
+        user->setDepartment(getString(record.department));
+        insertUser(move(user));
+    }
+
+    uint64_t nextBorrow = 0;
+    for (uint64_t i = 0; i < header.accountCount && valid; ++i) {
+        const SnapshotAccount& record = accountRecords[i];
+        uint64_t recordCount = uint64_t(record.currentCount) + record.historyCount;
+        if (nextBorrow + recordCount > header.borrowCount) {
+            valid = false;
+            break;
+        }
+
+        auto account = makePooled<Account>(accountPool, record.userID);
+        for (uint64_t j = 0; j < recordCount; ++j) {
+            const SnapshotBorrow& entry = borrowRecords[nextBorrow + j];
+            BorrowRecord borrow;
+            borrow.bookID = entry.bookID;
+            borrow.borrowDate = fromSnapshotTime(entry.borrowDate);
+            borrow.dueDate = fromSnapshotTime(entry.dueDate);
+            if (j < record.currentCount) {
+                account->addBorrow(borrow);
+            } else {
+                account->addToBorrowHistory(borrow);
+            }
+        }
+        account->addFine(record.totalFine);
+        nextBorrow += recordCount;
+        attachAccount(move(account));
+    }
+
+    for (uint64_t i = 0; i < header.reservationCount && valid; ++i) {
+        auto bookIt = books.find(reservationRecords[i].bookID);
+        if (bookIt != books.end()) {
+            restoreReservation(bookIt->second.get(), reservationRecords[i].userID);
+        }
+    }
+
+    // Changes the text export has not caught up with yet, replacing the ones
+    // recorded while the snapshot was being loaded
+    clearChanges();
+    markChanged(header.changedFiles);
+    for (uint64_t i = 0; i < header.changedAccountCount && valid; ++i) {
+        markAccountChanged(changedAccountRecords[i]);
+    }
+
+    if (!valid) {
+        cerr << "Error: Snapshot is corrupt: " << path << endl;
+        searchIndex.clear();
+        termTrie.clear();
+        termGrams.clear();
+        isbnIndex.clear();
+        bookColumns.clear();
+        reservationsByUser.clear();
+        dueIndex.clear();
+        books.clear();
+        users.clear();
+        accounts.clear();
+        return false;
+    }
+    return true;
+}
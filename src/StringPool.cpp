@@ -0,0 +1,82 @@
+#include "../header/StringPool.h"
+#include <mutex>
+
+using namespace std;
+
+// StringPool Implementation
+const size_t StringPool::FIRST_CHUNK_BITS;
+const size_t StringPool::FIRST_CHUNK;
+const size_t StringPool::CHUNK_COUNT;
+
+StringPool::StringPool() : count(0) {
+    for (auto& chunk : chunks) chunk.store(nullptr, memory_order_relaxed);
+    intern(string());
+}
+
+StringPool::~StringPool() {
+    for (auto& chunk : chunks) delete[] chunk.load(memory_order_relaxed);
+}
+
+// Chunk k starts at handle (FIRST_CHUNK << k) - FIRST_CHUNK, so the chunk is
+// the position of the highest set bit of handle + FIRST_CHUNK
+void StringPool::locate(StringHandle handle, size_t& chunk, size_t& offset) {
+    uint64_t position = uint64_t(handle) + FIRST_CHUNK;
+#if defined(__GNUC__) || defined(__clang__)
+    size_t highBit = 63 - __builtin_clzll(position);
+#else
+    size_t highBit = 0;
+    while (position >> (highBit + 1)) ++highBit;
+#endif
+    chunk = highBit - FIRST_CHUNK_BITS;
+    offset = position - (uint64_t(1) << highBit);
+}
+
+StringHandle StringPool::intern(const string& value) {
+    {
+        shared_lock<shared_mutex> lock(poolMutex);
+        auto it = handles.find(value);
+        if (it != handles.end()) return it->second;
+    }
+
+    unique_lock<shared_mutex> lock(poolMutex);
+    auto it = handles.find(value);
+    if (it != handles.end()) return it->second;
+
+    StringHandle handle = static_cast<StringHandle>(count.load(memory_order_relaxed));
+    size_t chunk, offset;
+    locate(handle, chunk, offset);
+    string* strings = chunks[chunk].load(memory_order_relaxed);
+    if (!strings) {
+        strings = new string[FIRST_CHUNK << chunk];
+        chunks[chunk].store(strings, memory_order_release);
+    }
+    // Nobody reads this slot until the handle is returned, and the string
+    // never moves afterwards, so the view used as key stays valid
+    strings[offset] = value;
+    handles.emplace(string_view(strings[offset]), handle);
+    count.store(size_t(handle) + 1, memory_order_release);
+    return handle;
+}
+
+bool StringPool::find(const string& value, StringHandle& handle) const {
+    shared_lock<shared_mutex> lock(poolMutex);
+    auto it = handles.find(value);
+    if (it == handles.end()) return false;
+    handle = it->second;
+    return true;
+}
+
+const string& StringPool::get(StringHandle handle) const {
+    size_t chunk, offset;
+    locate(handle, chunk, offset);
+    return chunks[chunk].load(memory_order_acquire)[offset];
+}
+
+size_t StringPool::size() const {
+    return count.load(memory_order_acquire);
+}
+
+StringPool& StringPool::global() {
+    static StringPool pool;
+    return pool;
+}
@@ -0,0 +1,103 @@
+#include "../header/TextScan.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__SSE2__)
+#define TEXT_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+static inline char foldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+static inline char upperCase(char c) {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - ('a' - 'A')) : c;
+}
+
+// Compare text against a needle that is already lowercase
+static inline bool matchesAt(const char* text, const string& needle) {
+    for (size_t i = 0; i < needle.size(); ++i) {
+        if (foldCase(text[i]) != needle[i]) return false;
+    }
+    return true;
+}
+
+static size_t findScalar(string_view text, const string& needle, size_t from) {
+    for (size_t i = from; i + needle.size() <= text.size(); ++i) {
+        if (foldCase(text[i]) == needle[0] && matchesAt(text.data() + i, needle)) return i;
+    }
+    return string_view::npos;
+}
+
+#ifdef TEXT_SCAN_X86
+// Each kernel tests a block of start positions: a position is a candidate
+// when both the needle's first and last characters match in either case.
+// Blocks stop where a full block of last characters would run past the end;
+// the scalar loop finishes the tail.
+static size_t findSSE2(string_view text, const string& needle, size_t from) {
+    const size_t lastOffset = needle.size() - 1;
+    const __m128i firstLower = _mm_set1_epi8(needle.front());
+    const __m128i firstUpper = _mm_set1_epi8(upperCase(needle.front()));
+    const __m128i lastLower = _mm_set1_epi8(needle.back());
+    const __m128i lastUpper = _mm_set1_epi8(upperCase(needle.back()));
+
+    size_t i = from;
+    for (; i + lastOffset + 16 <= text.size(); i += 16) {
+        __m128i firstBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        __m128i lastBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i + lastOffset));
+        __m128i firstEq = _mm_or_si128(_mm_cmpeq_epi8(firstBlock, firstLower), _mm_cmpeq_epi8(firstBlock, firstUpper));
+        __m128i lastEq = _mm_or_si128(_mm_cmpeq_epi8(lastBlock, lastLower), _mm_cmpeq_epi8(lastBlock, lastUpper));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(firstEq, lastEq)));
+        while (mask) {
+            size_t position = i + __builtin_ctz(mask);
+            if (matchesAt(text.data() + position, needle)) return position;
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(text, needle, i);
+}
+
+__attribute__((target("avx2")))
+static size_t findAVX2(string_view text, const string& needle, size_t from) {
+    const size_t lastOffset = needle.size() - 1;
+    const __m256i firstLower = _mm256_set1_epi8(needle.front());
+    const __m256i firstUpper = _mm256_set1_epi8(upperCase(needle.front()));
+    const __m256i lastLower = _mm256_set1_epi8(needle.back());
+    const __m256i lastUpper = _mm256_set1_epi8(upperCase(needle.back()));
+
+    size_t i = from;
+    for (; i + lastOffset + 32 <= text.size(); i += 32) {
+        __m256i firstBlock = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i));
+        __m256i lastBlock = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i + lastOffset));
+        __m256i firstEq = _mm256_or_si256(_mm256_cmpeq_epi8(firstBlock, firstLower), _mm256_cmpeq_epi8(firstBlock, firstUpper));
+        __m256i lastEq = _mm256_or_si256(_mm256_cmpeq_epi8(lastBlock, lastLower), _mm256_cmpeq_epi8(lastBlock, lastUpper));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(firstEq, lastEq)));
+        while (mask) {
+            size_t position = i + __builtin_ctz(mask);
+            if (matchesAt(text.data() + position, needle)) return position;
+            mask &= mask - 1;
+        }
+    }
+    return findSSE2(text, needle, i);
+}
+#endif
+
+// TextScan Implementation
+TextScan::TextScan(string_view needle) : needle(needle) {
+    for (char& c : this->needle) c = foldCase(c);
+}
+
+size_t TextScan::find(string_view text, size_t from) const {
+    if (from > text.size() || needle.size() > text.size() - from) return string_view::npos;
+    if (needle.empty()) return from;
+
+#ifdef TEXT_SCAN_X86
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+    return hasAVX2 ? findAVX2(text, needle, from) : findSSE2(text, needle, from);
+#else
+    return findScalar(text, needle, from);
+#endif
+}
+
+size_t TextScan::length() const { return needle.size(); }
@@ -0,0 +1,143 @@
+#include "../header/TrigramIndex.h"
+#include <algorithm>
+
+using namespace std;
+
+// TrigramIndex Implementation
+uint32_t TrigramIndex::packGram(const char* text) {
+    return uint32_t(static_cast<unsigned char>(text[0])) << 16 |
+           uint32_t(static_cast<unsigned char>(text[1])) << 8 |
+           uint32_t(static_cast<unsigned char>(text[2]));
+}
+
+vector<uint32_t> TrigramIndex::trigrams(string_view term) {
+    string padded = "$$" + string(term) + "$$";
+    vector<uint32_t> grams;
+    for (size_t i = 0; i + 3 <= padded.size(); ++i) {
+        grams.push_back(packGram(&padded[i]));
+    }
+    sort(grams.begin(), grams.end());
+    grams.erase(unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+void TrigramIndex::addTerm(const string& term) {
+    if (term.empty() || termIDs.count(term)) return;
+    uint32_t termID;
+    if (!freeIDs.empty()) {
+        termID = freeIDs.back();
+        freeIDs.pop_back();
+        terms[termID] = term;
+    } else {
+        termID = static_cast<uint32_t>(terms.size());
+        terms.push_back(term);
+    }
+    termIDs[term] = termID;
+    for (uint32_t gram : trigrams(term)) {
+        postings[gram].push_back(termID);
+    }
+}
+
+void TrigramIndex::removeTerm(const string& term) {
+    auto it = termIDs.find(term);
+    if (it == termIDs.end()) return;
+    uint32_t termID = it->second;
+    for (uint32_t gram : trigrams(term)) {
+        auto postingIt = postings.find(gram);
+        if (postingIt == postings.end()) continue;
+        auto& ids = postingIt->second;
+        ids.erase(remove(ids.begin(), ids.end(), termID), ids.end());
+        if (ids.empty()) postings.erase(postingIt);
+    }
+    terms[termID].clear();
+    freeIDs.push_back(termID);
+    termIDs.erase(it);
+}
+
+void TrigramIndex::clear() {
+    terms.clear();
+    freeIDs.clear();
+    termIDs.clear();
+    postings.clear();
+}
+
+size_t TrigramIndex::size() const { return termIDs.size(); }
+
+vector<TrigramIndex::Match> TrigramIndex::findSimilar(const string& word, int maxDistance) const {
+    vector<Match> matches;
+    vector<uint32_t> grams = trigrams(word);
+    auto check = [&](const string& term) {
+        if (term.empty()) return;
+        if (abs(static_cast<int>(term.size()) - static_cast<int>(word.size())) > maxDistance) return;
+        int distance = boundedEditDistance(word, term, maxDistance);
+        if (distance <= maxDistance) {
+            matches.push_back({term, distance});
+        }
+    };
+
+    // With enough edits to change every gram of the word, a close term need
+    // not share any gram with it, so the count filter cannot rule anything out
+    long long required = static_cast<long long>(grams.size()) - 3LL * maxDistance;
+    if (required < 1) {
+        for (const string& term : terms) check(term);
+    } else {
+        // Count shared grams per term, then keep the terms that pass the
+        // count and length filters and the edit-distance check
+        unordered_map<uint32_t, uint32_t> shared;
+        for (uint32_t gram : grams) {
+            auto postingIt = postings.find(gram);
+            if (postingIt == postings.end()) continue;
+            for (uint32_t termID : postingIt->second) {
+                ++shared[termID];
+            }
+        }
+        for (const auto& pair : shared) {
+            if (static_cast<long long>(pair.second) >= required) check(terms[pair.first]);
+        }
+    }
+
+    sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.term < b.term;
+    });
+    return matches;
+}
+
+vector<string> TrigramIndex::findContaining(string_view fragment) const {
+    vector<string> matches;
+    if (fragment.size() < 3) return matches;
+
+    const vector<uint32_t>* rarest = nullptr;
+    for (size_t i = 0; i + 3 <= fragment.size(); ++i) {
+        auto postingIt = postings.find(packGram(&fragment[i]));
+        if (postingIt == postings.end()) return matches;
+        if (!rarest || postingIt->second.size() < rarest->size()) rarest = &postingIt->second;
+    }
+    for (uint32_t termID : *rarest) {
+        if (terms[termID].find(fragment) != string::npos) {
+            matches.push_back(terms[termID]);
+        }
+    }
+    return matches;
+}
+
+// Two-row Levenshtein distance that gives up as soon as every entry in a row
+// exceeds the bound
+int TrigramIndex::boundedEditDistance(string_view a, string_view b, int maxDistance) {
+    if (a.size() > b.size()) swap(a, b);
+    vector<int> previous(a.size() + 1);
+    vector<int> current(a.size() + 1);
+    for (size_t i = 0; i <= a.size(); ++i) previous[i] = static_cast<int>(i);
+
+    for (size_t j = 1; j <= b.size(); ++j) {
+        current[0] = static_cast<int>(j);
+        int rowMin = current[0];
+        for (size_t i = 1; i <= a.size(); ++i) {
+            int substitution = previous[i - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+            current[i] = min({substitution, previous[i] + 1, current[i - 1] + 1});
+            rowMin = min(rowMin, current[i]);
+        }
+        if (rowMin > maxDistance) return maxDistance + 1;
+        swap(previous, current);
+    }
+    return min(previous[a.size()], maxDistance + 1);
+}
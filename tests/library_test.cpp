@@ -0,0 +1,413 @@
+// Behaviour tests for the in-memory Library: search, indexes and queries.
+//
+// Usage: library_test
+//
+// Each scenario builds a Library in memory and never loads or saves state,
+// so nothing is written to disk. Prints one line per scenario on stdout and
+// one line per failed check on stderr; the exit status is 0 only if every
+// check passed.
+
+#include "../header/LibrarySystem.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static size_t failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition \
+                 << endl;                                                       \
+            ++failures;                                                         \
+        }                                                                       \
+    } while (false)
+
+static unique_ptr<Book> makeBook(int bookID, const string& title, const string& author) {
+    return make_unique<Book>(bookID, title, author, "Test Publisher", 2000, "978-0-00-000000-0");
+}
+
+static vector<int> bookIDs(const vector<const Book*>& books) {
+    vector<int> ids;
+    for (const Book* book : books) ids.push_back(book->getBookID());
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// Word queries match every book holding all the words in its title or
+// author, in any case and order; other queries match as a substring.
+static void testSearch() {
+    Library library;
+    CHECK(library.addBook(makeBook(1, "The Silent River", "Ann Lake")));
+    CHECK(library.addBook(makeBook(2, "River Songs", "Tom Reed")));
+    CHECK(library.addBook(makeBook(3, "Silent Night", "Ann Brook")));
+
+    CHECK(bookIDs(library.searchBooks("river")) == vector<int>({1, 2}));
+    CHECK(bookIDs(library.searchBooks("RIVER silent")) == vector<int>({1}));
+    CHECK(bookIDs(library.searchBooks("ann")) == vector<int>({1, 3}));
+    CHECK(bookIDs(library.searchBooks("silent ann")) == vector<int>({1, 3}));
+    CHECK(bookIDs(library.searchBooks("ilent Riv")) == vector<int>({1}));
+    CHECK(bookIDs(library.searchBooks("ver So")) == vector<int>({2}));
+    CHECK(library.searchBooks("ocean").empty());
+
+    CHECK(library.removeBook(1));
+    CHECK(bookIDs(library.searchBooks("river")) == vector<int>({2}));
+    CHECK(bookIDs(library.searchBooks("ilent")) == vector<int>({3}));
+    CHECK(library.addBook(makeBook(4, "Silent River", "Ann Lake")));
+    CHECK(bookIDs(library.searchBooks("silent river")) == vector<int>({4}));
+}
+
+static vector<int> reservedIDs(const Library& library, int userID) {
+    return bookIDs(library.getReservedBooks(userID));
+}
+
+// The per-user reservation index must follow every change to the queues:
+// reserving, cancelling, the return that hands the copy to the first user
+// in the queue, and removing the book.
+static void testReservationIndex() {
+    Library library;
+    for (int userID : {111, 112, 113}) {
+        CHECK(library.addUser(make_unique<Student>(userID, "Student", "test")));
+    }
+    CHECK(library.addBook(makeBook(1, "Silent River", "Ann Lake")));
+    CHECK(library.addBook(makeBook(2, "River Songs", "Tom Reed")));
+
+    CHECK(library.borrowBook(111, 1));
+    CHECK(library.reserveBook(112, 1));
+    CHECK(library.reserveBook(113, 1));
+    CHECK(!library.reserveBook(112, 1));
+    CHECK(!library.reserveBook(112, 2));  // on the shelf
+    CHECK(reservedIDs(library, 112) == vector<int>({1}));
+    CHECK(reservedIDs(library, 113) == vector<int>({1}));
+
+    CHECK(library.cancelReservation(113, 1));
+    CHECK(!library.cancelReservation(113, 1));
+    CHECK(reservedIDs(library, 113).empty());
+    CHECK(reservedIDs(library, 112) == vector<int>({1}));
+
+    // The return serves 112, the front of the queue; 113 stays queued
+    CHECK(library.reserveBook(113, 1));
+    CHECK(library.returnBook(111, 1));
+    CHECK(reservedIDs(library, 112).empty());
+    CHECK(reservedIDs(library, 113) == vector<int>({1}));
+    CHECK(library.getBook(1)->getReservations() == vector<int>({113}));
+
+    CHECK(library.borrowBook(112, 2));
+    CHECK(library.reserveBook(113, 2));
+    CHECK(reservedIDs(library, 113) == vector<int>({1, 2}));
+    CHECK(library.removeBook(1));
+    CHECK(reservedIDs(library, 113) == vector<int>({2}));
+}
+
+// (userID, bookID) of each loan, in the order returned
+using LoanKeys = vector<pair<int, int>>;
+
+static LoanKeys loanKeys(const vector<BorrowInfo>& loans) {
+    LoanKeys keys;
+    for (const BorrowInfo& loan : loans) {
+        keys.emplace_back(loan.borrower->getUserID(), loan.book->getBookID());
+    }
+    return keys;
+}
+
+// Overdue loans come from the due-date index, earliest due date first, and
+// a loan counts as overdue only once its due date has passed
+static void testDueIndex() {
+    Library library;
+    CHECK(library.addUser(make_unique<Student>(111, "Student", "test")));
+    CHECK(library.addUser(make_unique<Student>(112, "Student", "test")));
+    CHECK(library.addUser(make_unique<Faculty>(211, "Faculty", "test")));
+    for (int bookID = 1; bookID <= 4; ++bookID) {
+        CHECK(library.addBook(makeBook(bookID, "Book " + to_string(bookID), "Ann Lake")));
+    }
+
+    auto now = chrono::system_clock::now();
+    auto later = now + chrono::hours(24 * 40);
+    CHECK(library.borrowBook(211, 1));
+    CHECK(library.borrowBook(111, 2));
+    CHECK(library.borrowBook(112, 3));
+    CHECK(library.borrowBook(111, 4));
+
+    CHECK(library.getOverdueBooks(now).empty());
+    vector<BorrowInfo> overdue = library.getOverdueBooks(later);
+    CHECK(loanKeys(overdue) == LoanKeys({{211, 1}, {111, 2}, {112, 3}, {111, 4}}));
+    CHECK(loanKeys(library.getOverdueBooks(later, 2)) == LoanKeys({{211, 1}, {111, 2}}));
+    if (overdue.size() == 4) {
+        CHECK(loanKeys(library.getOverdueBooks(overdue[2].dueDate)) ==
+              LoanKeys({{211, 1}, {111, 2}}));
+    }
+
+    size_t seen = 0;
+    CHECK(library.forEachOverdue(later, [&seen](const BorrowInfo&) { return ++seen < 3; }) == 3);
+
+    // Returning a loan drops it from the index; borrowing again adds it
+    // back with a later due date
+    CHECK(library.returnBook(111, 2));
+    CHECK(library.returnBook(211, 1));
+    CHECK(library.borrowBook(211, 2));
+    CHECK(loanKeys(library.getOverdueBooks(later)) == LoanKeys({{112, 3}, {111, 4}, {211, 2}}));
+
+    // Loans of a removed book are skipped
+    CHECK(library.removeBook(3));
+    CHECK(loanKeys(library.getOverdueBooks(later)) == LoanKeys({{111, 4}, {211, 2}}));
+}
+
+static unique_ptr<User> makeUser(unique_ptr<User> user, const string& department) {
+    user->setDepartment(department);
+    return user;
+}
+
+// Follow resume tokens from the first page to the last
+static LoanKeys readAllPages(const Library& library, LoanQuery query, size_t& pages) {
+    LoanKeys keys;
+    LoanPage page;
+    pages = 0;
+    do {
+        if (!library.getBorrowedBooksPage(query, page)) break;
+        ++pages;
+        LoanKeys pageKeys = loanKeys(page.loans);
+        keys.insert(keys.end(), pageKeys.begin(), pageKeys.end());
+        query.resumeToken = page.nextToken;
+    } while (!page.nextToken.empty() && pages < 100);
+    return keys;
+}
+
+// The loan pager walks the due-date index a page at a time. Following the
+// resume tokens must return every matching loan once, in due-date order,
+// with the role and department filters applied before paging.
+static void testLoanPager() {
+    Library library;
+    CHECK(library.addUser(makeUser(make_unique<Student>(111, "Student", "test"), "Physics")));
+    CHECK(library.addUser(makeUser(make_unique<Student>(112, "Student", "test"), "History")));
+    CHECK(library.addUser(makeUser(make_unique<Faculty>(211, "Faculty", "test"), "Physics")));
+    for (int bookID = 1; bookID <= 6; ++bookID) {
+        CHECK(library.addBook(makeBook(bookID, "Book " + to_string(bookID), "Ann Lake")));
+    }
+    CHECK(library.borrowBook(111, 1));
+    CHECK(library.borrowBook(211, 2));
+    CHECK(library.borrowBook(112, 3));
+    CHECK(library.borrowBook(111, 4));
+    CHECK(library.borrowBook(211, 5));
+
+    LoanQuery query;
+    query.pageSize = 2;
+    size_t pages = 0;
+    CHECK(readAllPages(library, query, pages) ==
+          LoanKeys({{111, 1}, {211, 2}, {112, 3}, {111, 4}, {211, 5}}));
+    CHECK(pages == 3);
+
+    // A page that ends on the last match has no token
+    query.pageSize = 5;
+    LoanPage page;
+    CHECK(library.getBorrowedBooksPage(query, page));
+    CHECK(page.loans.size() == 5 && page.nextToken.empty());
+
+    query.pageSize = 1;
+    query.role = "Student";
+    CHECK(readAllPages(library, query, pages) == LoanKeys({{111, 1}, {112, 3}, {111, 4}}));
+    CHECK(pages == 3);
+    query.department = "Physics";
+    CHECK(readAllPages(library, query, pages) == LoanKeys({{111, 1}, {111, 4}}));
+    query.role.clear();
+    CHECK(readAllPages(library, query, pages) == LoanKeys({{111, 1}, {211, 2}, {111, 4}, {211, 5}}));
+    query.department = "Chemistry";
+    CHECK(library.getBorrowedBooksPage(query, page) && page.loans.empty() && page.nextToken.empty());
+
+    // The token names the last loan returned, so it still resumes at the
+    // right place after that loan is returned
+    query = LoanQuery();
+    query.pageSize = 2;
+    CHECK(library.getBorrowedBooksPage(query, page) && !page.nextToken.empty());
+    CHECK(library.returnBook(211, 2));
+    CHECK(library.borrowBook(112, 6));
+    query.resumeToken = page.nextToken;
+    CHECK(readAllPages(library, query, pages) == LoanKeys({{112, 3}, {111, 4}, {211, 5}, {112, 6}}));
+
+    query.resumeToken = "not a token";
+    CHECK(!library.getBorrowedBooksPage(query, page));
+}
+
+static vector<string> completionTexts(const vector<Completion>& completions) {
+    vector<string> texts;
+    for (const Completion& completion : completions) texts.push_back(completion.text);
+    return texts;
+}
+
+// Autocomplete ranks the completions of the last word by how many books
+// hold them, restricted to books matching the earlier words, and follows
+// the book counts as books are removed
+static void testAutocomplete() {
+    Library library;
+    const vector<string> titles = {"River One", "River Two", "River Three", "Silent River",
+                                   "River Ridge", "Ridge Road", "Ridge Walk", "Silent Ridge",
+                                   "Rivet Gun", "Silent Rivet", "Rim Shot"};
+    for (size_t i = 0; i < titles.size(); ++i) {
+        CHECK(library.addBook(makeBook(int(i) + 1, titles[i], "Ann Lake")));
+    }
+
+    vector<Completion> completions = library.autocomplete("RI", 10);
+    CHECK(completionTexts(completions) == vector<string>({"river", "ridge", "rivet", "rim"}));
+    if (completions.size() == 4) {
+        CHECK(completions[0].bookCount == 5 && completions[0].bookIDs == vector<int>({1, 2, 3, 4, 5}));
+        CHECK(completions[1].bookCount == 4 && completions[1].bookIDs == vector<int>({5, 6, 7, 8}));
+        CHECK(completions[3].bookCount == 1 && completions[3].bookIDs == vector<int>({11}));
+    }
+    CHECK(completionTexts(library.autocomplete("ri", 2)) == vector<string>({"river", "ridge"}));
+    CHECK(completionTexts(library.autocomplete("riv", 10)) == vector<string>({"river", "rivet"}));
+    CHECK(completionTexts(library.autocomplete("river", 10)) == vector<string>({"river"}));
+    CHECK(library.autocomplete("rx", 10).empty());
+    CHECK(library.autocomplete("ri", 0).empty());
+
+    completions = library.autocomplete("silent ri", 10);
+    CHECK(completionTexts(completions) ==
+          vector<string>({"silent river", "silent ridge", "silent rivet"}));
+    CHECK(!completions.empty() && completions[0].bookCount == 1 &&
+          completions[0].bookIDs == vector<int>({4}));
+    CHECK(library.autocomplete("ocean ri", 10).empty());
+
+    CHECK(library.removeBook(1));
+    CHECK(library.removeBook(2));
+    CHECK(completionTexts(library.autocomplete("ri", 10)) ==
+          vector<string>({"ridge", "river", "rivet", "rim"}));
+    CHECK(library.removeBook(11));
+    CHECK(completionTexts(library.autocomplete("ri", 10)) == vector<string>({"ridge", "river", "rivet"}));
+
+    // Only the first few book IDs are listed, but all are counted
+    for (int bookID = 100; bookID < 120; ++bookID) {
+        CHECK(library.addBook(makeBook(bookID, "Echo " + to_string(bookID), "Ann Lake")));
+    }
+    completions = library.autocomplete("ech", 10);
+    CHECK(completions.size() == 1 && completions[0].bookCount == 20 &&
+          completions[0].bookIDs.size() < 20 && completions[0].bookIDs.front() == 100);
+}
+
+static vector<int> rankedIDs(const vector<const Book*>& books) {
+    vector<int> ids;
+    for (const Book* book : books) ids.push_back(book->getBookID());
+    return ids;
+}
+
+// Fuzzy search allows one edit up to four letters, two up to six and three
+// beyond, and ranks books by total edit distance. A close term may share no
+// trigram with a misspelt short word ("cot" and "cat"), and must still be
+// found.
+static void testFuzzySearch() {
+    Library library;
+    CHECK(library.addBook(makeBook(1, "The Cat", "Ann Lake")));
+    CHECK(library.addBook(makeBook(2, "Cart Wheels", "Ann Lake")));
+    CHECK(library.addBook(makeBook(3, "Garden Path", "Ann Lake")));
+    CHECK(library.addBook(makeBook(4, "Gardens Lost", "Ann Lake")));
+    CHECK(library.addBook(makeBook(5, "Harbour Lights", "Tom Reed")));
+    CHECK(library.addBook(makeBook(6, "Silent Harbor", "Tom Reed")));
+
+    CHECK(rankedIDs(library.fuzzySearch("cot", 10)) == vector<int>({1}));
+    CHECK(rankedIDs(library.fuzzySearch("cat", 10)) == vector<int>({1, 2}));
+    CHECK(rankedIDs(library.fuzzySearch("cars", 10)) == vector<int>({2}));
+    CHECK(library.fuzzySearch("ct", 10).empty());
+
+    CHECK(rankedIDs(library.fuzzySearch("gbrdbn", 10)) == vector<int>({3}));
+    CHECK(rankedIDs(library.fuzzySearch("gardn", 10)) == vector<int>({3, 4}));
+    CHECK(rankedIDs(library.fuzzySearch("gardn", 1)) == vector<int>({3}));
+    vector<int> harbour = bookIDs(library.fuzzySearch("xarxoux", 10));
+    CHECK(find(harbour.begin(), harbour.end(), 5) != harbour.end());
+
+    CHECK(rankedIDs(library.fuzzySearch("silnt harbr", 10)) == vector<int>({6}));
+    CHECK(rankedIDs(library.fuzzySearch("harbor reed", 10)) == vector<int>({6, 5}));
+    CHECK(library.fuzzySearch("silnt lake", 10).empty());
+}
+
+static uint64_t isbnKey(const string& isbn) {
+    uint64_t key = 0;
+    return Library::normalizeISBN(isbn, key) ? key : 0;
+}
+
+// ISBN-10 and ISBN-13 forms of the same book normalize to one ISBN-13 key,
+// with or without hyphens and spaces, and lookups accept either form
+static void testISBN() {
+    CHECK(isbnKey("978-0-306-40615-7") == 9780306406157ULL);
+    CHECK(isbnKey("978 0 306 40615 7") == 9780306406157ULL);
+    CHECK(isbnKey("0-306-40615-2") == 9780306406157ULL);
+    CHECK(isbnKey("0306406152") == 9780306406157ULL);
+    CHECK(isbnKey("080442957X") == 9780804429573ULL);
+    CHECK(isbnKey("0-8044-2957-x") == 9780804429573ULL);
+    CHECK(isbnKey("979-10-90636-07-1") == 9791090636071ULL);
+
+    CHECK(isbnKey("") == 0);
+    CHECK(isbnKey("12345") == 0);
+    CHECK(isbnKey("03064061521") == 0);
+    CHECK(isbnKey("X306406152") == 0);
+    CHECK(isbnKey("978030640615X") == 0);
+    CHECK(isbnKey("ISBN 0306406152") == 0);
+
+    Library library;
+    auto makeISBNBook = [](int bookID, const string& isbn) {
+        return make_unique<Book>(bookID, "Book", "Ann Lake", "Test Publisher", 2000, isbn);
+    };
+    CHECK(library.addBook(makeISBNBook(7, "0-306-40615-2")));
+    CHECK(library.addBook(makeISBNBook(3, "9780306406157")));
+    CHECK(library.addBook(makeISBNBook(5, "0-8044-2957-X")));
+    CHECK(library.addBook(makeISBNBook(9, "not an isbn")));
+
+    // Books sharing an ISBN resolve to the lowest book ID
+    const Book* book = library.getBookByISBN("978-0-306-40615-7");
+    CHECK(book != nullptr && book->getBookID() == 3);
+    book = library.getBookByISBN("0306406152");
+    CHECK(book != nullptr && book->getBookID() == 3);
+    book = library.getBookByISBN("9780804429573");
+    CHECK(book != nullptr && book->getBookID() == 5);
+    CHECK(library.getBookByISBN("not an isbn") == nullptr);
+    CHECK(library.getBookByISBN("978-1-4028-9462-6") == nullptr);
+
+    CHECK(library.removeBook(3));
+    book = library.getBookByISBN("0306406152");
+    CHECK(book != nullptr && book->getBookID() == 7);
+    CHECK(library.removeBook(7));
+    CHECK(library.getBookByISBN("0306406152") == nullptr);
+}
+
+// Interned strings are stored in chunks of growing size; every handle must
+// keep resolving to its value across the chunk boundaries
+static void testStringPool() {
+    StringPool pool;
+    CHECK(pool.size() == 1 && pool.get(0).empty());
+    CHECK(pool.intern("") == 0);
+
+    vector<StringHandle> handles;
+    for (int i = 0; i < 5000; ++i) {
+        handles.push_back(pool.intern("value " + to_string(i)));
+    }
+    CHECK(pool.size() == 5001);
+    for (int i = 0; i < 5000; ++i) {
+        CHECK(pool.get(handles[i]) == "value " + to_string(i));
+        CHECK(pool.intern("value " + to_string(i)) == handles[i]);
+    }
+    StringHandle found = 0;
+    CHECK(pool.find("value 4999", found) && found == handles.back());
+    CHECK(!pool.find("value 5000", found));
+}
+
+int main() {
+    // The library reports progress on stdout; keep stdout for the results
+    ostream results(cout.rdbuf());
+    cout.rdbuf(cerr.rdbuf());
+    auto run = [&](const char* name, void (*scenario)()) {
+        size_t failedBefore = failures;
+        scenario();
+        results << name << ": " << (failures == failedBefore ? "passed" : "FAILED") << endl;
+    };
+
+    run("search", testSearch);
+    run("reservationIndex", testReservationIndex);
+    run("dueIndex", testDueIndex);
+    run("loanPager", testLoanPager);
+    run("autocomplete", testAutocomplete);
+    run("fuzzySearch", testFuzzySearch);
+    run("isbn", testISBN);
+    run("stringPool", testStringPool);
+    cout.rdbuf(results.rdbuf());
+
+    cout << (failures == 0 ? "All tests passed" : to_string(failures) + " checks failed") << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,454 @@
+// Restart tests for the persistence layer.
+//
+// Usage: persistence_test
+//
+// Each scenario runs a Library against an empty data directory, destroys it,
+// then loads the state again and checks what survived. All files are written
+// to a scratch directory under the system temp directory. Prints one line per
+// failed check on stderr; the exit status is 0 only if every check passed.
+
+#include "../header/LibrarySystem.h"
+#include "../header/Snapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static size_t failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition \
+                 << endl;                                                       \
+            ++failures;                                                         \
+        }                                                                       \
+    } while (false)
+
+static unique_ptr<Book> makeBook(int bookID, int copies) {
+    return make_unique<Book>(bookID, "Test Book " + to_string(bookID), "Test Author",
+                             "Test Publisher", 2000, "978-0-00-000000-0", copies);
+}
+
+// A book must keep at least one copy. A zero-copy book used to be accepted,
+// written into the snapshot at the next checkpoint and then make the whole
+// snapshot unreadable, losing every change made after it.
+static void testBookCopies() {
+    {
+        Library library;
+        CHECK(library.loadState());
+        CHECK(!library.addBook(makeBook(1, 0)));
+        CHECK(!library.addBook(makeBook(2, -1)));
+        CHECK(library.getBook(1) == nullptr);
+        CHECK(library.getBook(2) == nullptr);
+
+        CHECK(library.addBook(makeBook(3, 2)));
+        CHECK(!library.setCopies(3, 0));
+        CHECK(library.getBook(3)->getCopies() == 2);
+
+        CHECK(library.addUser(make_unique<Student>(111, "Test Student", "test")));
+        CHECK(library.borrowBook(111, 3));
+        library.checkpoint();
+        CHECK(library.addBook(makeBook(4, 1)));
+        CHECK(library.borrowBook(111, 4));
+    }
+
+    Library library;
+    CHECK(library.loadState());
+    CHECK(library.getBook(1) == nullptr);
+    CHECK(library.getBook(3) != nullptr && library.getBook(3)->getAvailableCopies() == 1);
+    CHECK(library.getBook(4) != nullptr && !library.getBook(4)->isAvailable());
+    Account* account = library.getAccount(111);
+    CHECK(account != nullptr && account->getCurrentBorrows().size() == 2);
+}
+
+static vector<int> bookIDs(const vector<const Book*>& books) {
+    vector<int> ids;
+    for (const Book* book : books) ids.push_back(book->getBookID());
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+static unique_ptr<Book> makeTitledBook(int bookID, const string& title) {
+    return make_unique<Book>(bookID, title, "Test Author", "Test Publisher", 2000,
+                             "978-0-00-000000-0");
+}
+
+// The search index, the autocomplete trie and the trigram index are stored
+// in the snapshot. After a reload they must match the books exactly, and
+// keep matching as books are added and removed.
+static void testIndexReload() {
+    {
+        Library library;
+        CHECK(library.loadState());
+        CHECK(library.addBook(makeTitledBook(1, "Alpha River")));
+        CHECK(library.addBook(makeTitledBook(2, "Alpha Night")));
+        CHECK(library.addBook(makeTitledBook(3, "Alpha Garden")));
+        CHECK(library.removeBook(3));
+        library.checkpoint();
+        // Replayed from the journal on top of the snapshot
+        CHECK(library.addBook(makeTitledBook(4, "Silent Alpha")));
+    }
+
+    Library library;
+    CHECK(library.loadState());
+    CHECK(bookIDs(library.searchBooks("alpha")) == vector<int>({1, 2, 4}));
+    vector<Completion> completions = library.autocomplete("alp", 5);
+    CHECK(completions.size() == 1);
+    CHECK(!completions.empty() && completions[0].text == "alpha" &&
+          completions[0].bookCount == 3 && completions[0].bookIDs == vector<int>({1, 2, 4}));
+    CHECK(bookIDs(library.fuzzySearch("alpah", 10)) == vector<int>({1, 2, 4}));
+
+    CHECK(library.removeBook(1));
+    CHECK(library.removeBook(4));
+    CHECK(bookIDs(library.searchBooks("alpha")) == vector<int>({2}));
+    CHECK(bookIDs(library.searchBooks("river")).empty());
+    CHECK(bookIDs(library.fuzzySearch("alpah", 10)) == vector<int>({2}));
+    completions = library.autocomplete("alp", 5);
+    CHECK(completions.size() == 1 && completions[0].bookCount == 1);
+}
+
+// Snapshots of any other format version are refused rather than misread
+static void testSnapshotVersion() {
+    {
+        Library library;
+        CHECK(library.loadState());
+        CHECK(library.addBook(makeTitledBook(1, "Alpha River")));
+        library.checkpoint();
+    }
+
+    fstream snapshot("data/library.snap", ios::in | ios::out | ios::binary);
+    SnapshotHeader header;
+    CHECK(snapshot.read(reinterpret_cast<char*>(&header), sizeof(header)).good());
+    uint32_t version = header.version;
+    header.version = version - 1;
+    snapshot.seekp(0);
+    snapshot.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    snapshot.close();
+    {
+        Library library;
+        CHECK(!library.loadState());
+    }
+
+    snapshot.open("data/library.snap", ios::in | ios::out | ios::binary);
+    header.version = version;
+    snapshot.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    snapshot.close();
+    Library library;
+    CHECK(library.loadState());
+    CHECK(bookIDs(library.searchBooks("alpha")) == vector<int>({1}));
+}
+
+static size_t borrowCount(Library& library, int userID) {
+    Account* account = library.getAccount(userID);
+    return account ? account->getCurrentBorrows().size() : 0;
+}
+
+static string readJournal() {
+    ifstream file("data/journal.txt", ios::binary);
+    return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+// Crossing the checkpoint threshold hands the checkpoint to a background
+// thread; the snapshot appears without another call and the journal is cut
+// back to the records logged after it.
+static void testBackgroundCheckpoint() {
+    const int bookCount = 1200;
+    {
+        Library library;
+        CHECK(library.loadState());
+        for (int bookID = 1; bookID <= bookCount; ++bookID) {
+            CHECK(library.addBook(makeBook(bookID, 1)));
+        }
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+        while (!filesystem::exists("data/library.snap") && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        CHECK(filesystem::exists("data/library.snap"));
+        CHECK(library.waitDurable(library.getLastSequence()));
+        string journal = readJournal();
+        CHECK(count(journal.begin(), journal.end(), '\n') < bookCount);
+    }
+
+    Library library;
+    CHECK(library.loadState());
+    CHECK(library.getAllBooks().size() == size_t(bookCount));
+}
+
+// Books and accounts agree: every copy off the shelf is held by one account,
+// and no book is held by more accounts than it has copies
+static bool loansMatchCopies(Library& library, int bookCount, const vector<int>& userIDs) {
+    vector<int> held(bookCount + 1, 0);
+    for (int userID : userIDs) {
+        Account* account = library.getAccount(userID);
+        if (!account) return false;
+        for (const auto& borrow : account->getCurrentBorrows()) {
+            if (borrow.bookID < 1 || borrow.bookID > bookCount) return false;
+            ++held[borrow.bookID];
+        }
+    }
+    for (int bookID = 1; bookID <= bookCount; ++bookID) {
+        const Book* book = library.getBook(bookID);
+        if (!book || book->getCopies() - book->getAvailableCopies() != held[bookID]) return false;
+    }
+    return true;
+}
+
+// Each user's current loans, as (userID, bookID) pairs
+static vector<pair<int, int>> currentLoans(Library& library, const vector<int>& userIDs) {
+    vector<pair<int, int>> loans;
+    for (int userID : userIDs) {
+        for (const auto& borrow : library.getAccount(userID)->getCurrentBorrows()) {
+            loans.emplace_back(userID, borrow.bookID);
+        }
+    }
+    sort(loans.begin(), loans.end());
+    return loans;
+}
+
+// Checkpoints and full loan reports read the library through a copy-on-write
+// view while borrows and returns carry on. Each view, and so each snapshot,
+// must still hold one consistent state, and the last snapshot plus the
+// journal must give back the state at shutdown.
+static void testCheckpointDuringBorrows() {
+    // Idle users make each view take long enough for many borrows and
+    // returns to land while it is open
+    const int bookCount = 20;
+    const int idleUserCount = 4000;
+    const int workerCount = 4;
+    vector<int> userIDs;
+    vector<pair<int, int>> finalLoans;
+    {
+        Library library;
+        CHECK(library.loadState());
+        for (int bookID = 1; bookID <= bookCount; ++bookID) {
+            CHECK(library.addBook(makeBook(bookID, 1)));
+        }
+        // Idle users in between spread the active ones over the whole scan
+        int idleUserID = 1000;
+        for (int userID = 100; userID < 100 + 2 * workerCount; ++userID) {
+            for (int i = 0; i < idleUserCount / (2 * workerCount); ++i) {
+                CHECK(library.addUser(make_unique<Student>(idleUserID++, "Idle Student", "test")));
+            }
+            CHECK(library.addUser(make_unique<Student>(userID, "Test Student", "test")));
+            userIDs.push_back(userID);
+        }
+
+        atomic<bool> stop{false};
+        vector<thread> workers;
+        for (int worker = 0; worker < workerCount; ++worker) {
+            workers.emplace_back([&library, &stop, worker] {
+                unsigned state = 12345u + worker;
+                while (!stop) {
+                    state = state * 1103515245u + 12345u;
+                    int userID = 100 + 2 * worker + int(state >> 30) % 2;
+                    int bookID = 1 + int((state >> 8) % bookCount);
+                    if (!library.borrowBook(userID, bookID)) library.returnBook(userID, bookID);
+                }
+            });
+        }
+        // With one copy per book, a view mixing accounts from before and
+        // after a return and borrow would show a book lent out twice
+        bool viewsConsistent = true;
+        for (int i = 0; i < 10; ++i) {
+            library.checkpoint();
+            vector<int> lent;
+            for (const BorrowInfo& loan : library.getAllBorrowedBooks()) {
+                lent.push_back(loan.book->getBookID());
+            }
+            sort(lent.begin(), lent.end());
+            viewsConsistent = viewsConsistent && adjacent_find(lent.begin(), lent.end()) == lent.end();
+        }
+        CHECK(viewsConsistent);
+        stop = true;
+        for (auto& worker : workers) worker.join();
+
+        CHECK(loansMatchCopies(library, bookCount, userIDs));
+        finalLoans = currentLoans(library, userIDs);
+        CHECK(library.waitDurable(library.getLastSequence()));
+    }
+
+    // The snapshot on its own
+    filesystem::rename("data/journal.txt", "data/journal.saved");
+    {
+        Library library;
+        CHECK(library.loadState());
+        CHECK(loansMatchCopies(library, bookCount, userIDs));
+    }
+
+    filesystem::rename("data/journal.saved", "data/journal.txt");
+    Library library;
+    CHECK(library.loadState());
+    CHECK(loansMatchCopies(library, bookCount, userIDs));
+    CHECK(currentLoans(library, userIDs) == finalLoans);
+}
+
+#ifndef _WIN32
+// Run `session` in a child process that then dies without closing anything,
+// as if the process had crashed. True if the session reported success.
+static bool runAndCrash(const function<bool()>& session) {
+    cout.flush();
+    pid_t child = fork();
+    if (child == 0) _exit(session() ? 0 : 1);
+    int status = 0;
+    return child > 0 && waitpid(child, &status, 0) == child && WIFEXITED(status) &&
+           WEXITSTATUS(status) == 0;
+}
+
+// A record that waitDurable reported as written must survive a crash, even
+// when the crash left a half-written record behind and the next session
+// appended after it.
+static void testJournalCrash() {
+    bool firstSession = runAndCrash([] {
+        Library library;
+        bool ok = library.loadState() &&
+                  library.addUser(make_unique<Student>(111, "Test Student", "test")) &&
+                  library.addBook(makeBook(1, 1)) && library.addBook(makeBook(2, 1)) &&
+                  library.addBook(makeBook(3, 1)) && library.borrowBook(111, 1) &&
+                  library.waitDurable(library.getLastSequence());
+        // Die in the middle of writing the next record
+        ofstream("data/journal.txt", ios::app | ios::binary) << "BORROW|111|2|17";
+        return ok;
+    });
+    CHECK(firstSession);
+
+    bool secondSession = runAndCrash([] {
+        Library library;
+        return library.loadState() && borrowCount(library, 111) == 1 &&
+               library.getBook(2)->isAvailable() && library.borrowBook(111, 3) &&
+               library.waitDurable(library.getLastSequence());
+    });
+    CHECK(secondSession);
+
+    Library library;
+    CHECK(library.loadState());
+    CHECK(borrowCount(library, 111) == 2);
+    CHECK(!library.getBook(1)->isAvailable());
+    CHECK(library.getBook(2)->isAvailable());
+    CHECK(!library.getBook(3)->isAvailable());
+    CHECK(readJournal().find("BORROW|111|2|") == string::npos);
+}
+
+// A batch the writer fails to write must not count as durable, and must not
+// leave a partial record in the file: it is cut off again and retried. The
+// file size limit makes the writes fail partway through.
+static void testJournalWriteFailure() {
+    bool session = runAndCrash([] {
+        signal(SIGXFSZ, SIG_IGN);
+        Library library;
+        if (!library.loadState() ||
+            !library.addUser(make_unique<Student>(111, "Test Student", "test")) ||
+            !library.addBook(makeBook(1, 1)) ||
+            !library.waitDurable(library.getLastSequence())) {
+            return false;
+        }
+
+        rlimit original;
+        getrlimit(RLIMIT_FSIZE, &original);
+        rlimit limited = original;
+        limited.rlim_cur = filesystem::file_size("data/journal.txt") + 5;
+        setrlimit(RLIMIT_FSIZE, &limited);
+
+        bool ok = library.borrowBook(111, 1);
+        uint64_t sequence = library.getLastSequence();
+        this_thread::sleep_for(chrono::milliseconds(100));
+        ok = ok && library.getDurableSequence() < sequence;
+
+        setrlimit(RLIMIT_FSIZE, &original);
+        return ok && library.waitDurable(sequence);
+    });
+    CHECK(session);
+
+    Library library;
+    CHECK(library.loadState());
+    CHECK(borrowCount(library, 111) == 1);
+    string journal = readJournal();
+    size_t borrow = journal.find("BORROW|111|1|");
+    CHECK(borrow != string::npos && journal.find("BORROW|", borrow + 1) == string::npos);
+}
+
+// Records still queued when a checkpoint truncates the journal must not
+// count as durable until they are on disk. Here the rewrite fails (its
+// temporary path is a directory) and so does the append to the old journal
+// (file size limit), so the record stays queued until the limit is lifted.
+static void testJournalTruncateFailure() {
+    bool session = runAndCrash([] {
+        signal(SIGXFSZ, SIG_IGN);
+        Journal journal("data/journal.txt");
+        journal.configure(chrono::seconds(10), JournalSync::NONE);
+        if (!journal.open(0)) return false;
+        journal.append("FIRST");
+        bool ok = journal.waitDurable(journal.append("SECOND"));
+        // Queued for a full flush interval unless someone waits for it
+        uint64_t sequence = journal.append("THIRD");
+
+        filesystem::create_directory("data/journal.txt.tmp");
+        rlimit original;
+        getrlimit(RLIMIT_FSIZE, &original);
+        rlimit limited = original;
+        limited.rlim_cur = filesystem::file_size("data/journal.txt") + 1;
+        setrlimit(RLIMIT_FSIZE, &limited);
+
+        journal.truncateThrough(1);
+        ok = ok && journal.isOpen() && journal.getDurableSequence() < sequence;
+
+        setrlimit(RLIMIT_FSIZE, &original);
+        filesystem::remove("data/journal.txt.tmp");
+        ok = ok && journal.waitDurable(sequence);
+        journal.close();
+        return ok;
+    });
+    CHECK(session);
+    CHECK(readJournal() == "FIRST\nSECOND\nTHIRD\n");
+}
+#endif
+
+int main() {
+    // Library persists under ./data, so run inside a scratch directory
+    filesystem::path scratch = filesystem::temp_directory_path() / "lms-persistence-test";
+    filesystem::path originalDir = filesystem::current_path();
+
+    // The library reports progress on stdout; keep stdout for the results
+    ostream results(cout.rdbuf());
+    cout.rdbuf(cerr.rdbuf());
+    auto run = [&](const char* name, void (*scenario)()) {
+        filesystem::current_path(originalDir);
+        filesystem::remove_all(scratch);
+        filesystem::create_directories(scratch / "data" / "accounts");
+        filesystem::current_path(scratch);
+
+        size_t failedBefore = failures;
+        scenario();
+        results << name << ": " << (failures == failedBefore ? "passed" : "FAILED") << endl;
+    };
+
+    run("bookCopies", testBookCopies);
+    run("indexReload", testIndexReload);
+    run("snapshotVersion", testSnapshotVersion);
+    run("backgroundCheckpoint", testBackgroundCheckpoint);
+    run("checkpointDuringBorrows", testCheckpointDuringBorrows);
+#ifndef _WIN32
+    run("journalCrash", testJournalCrash);
+    run("journalWriteFailure", testJournalWriteFailure);
+    run("journalTruncateFailure", testJournalTruncateFailure);
+#endif
+    cout.rdbuf(results.rdbuf());
+
+    filesystem::current_path(originalDir);
+    filesystem::remove_all(scratch);
+    cout << (failures == 0 ? "All tests passed" : to_string(failures) + " checks failed") << endl;
+    return failures == 0 ? 0 : 1;
+}
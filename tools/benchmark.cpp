@@ -0,0 +1,223 @@
+// Microbenchmarks for the core Library operations.
+//
+// Usage: benchmark [--ops N] [catalogSize...]
+//
+// Builds a synthetic catalog for every requested size (default 10000), times
+// each operation individually and prints latency percentiles and throughput
+// as JSON on stdout. Progress goes to stderr. All files are written to a
+// scratch directory under the system temp directory.
+
+#include "../header/LibrarySystem.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Accounts changed before each timed saveState
+static const size_t SAVE_CHANGED_ACCOUNTS = 1000;
+
+struct BenchmarkResult {
+    size_t catalogSize;
+    string operation;
+    vector<double> samples;  // nanoseconds per call
+};
+
+static const vector<string> TITLE_WORDS = {
+    "river", "night", "garden", "empire", "shadow", "children", "guide", "silent",
+    "mountain", "house", "secret", "ocean", "golden", "winter", "glass", "city",
+    "history", "dream", "stone", "song", "journey", "fire", "letters", "island"
+};
+
+static const vector<string> AUTHOR_NAMES = {
+    "Narayan", "Seth", "Rushdie", "Roy", "Desai", "Ghosh", "Tagore", "Premchand",
+    "Mistry", "Lahiri", "Chandra", "Anand", "Markandaya", "Nagarkar", "Adiga", "Shanbhag"
+};
+
+static const vector<string> PUBLISHERS = {
+    "Penguin India", "HarperCollins", "Rupa Publications", "Oxford University Press",
+    "Vintage", "Picador", "Bloomsbury", "Westland"
+};
+
+template<typename Func>
+static void measure(BenchmarkResult& result, size_t iterations, Func&& operation) {
+    result.samples.reserve(result.samples.size() + iterations);
+    for (size_t i = 0; i < iterations; ++i) {
+        auto start = chrono::steady_clock::now();
+        operation(i);
+        auto end = chrono::steady_clock::now();
+        result.samples.push_back(static_cast<double>(
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count()));
+    }
+}
+
+static void writeJson(ostream& out, const vector<BenchmarkResult>& results) {
+    out << "{\n  \"results\": [";
+    for (size_t r = 0; r < results.size(); ++r) {
+        vector<double> samples = results[r].samples;
+        sort(samples.begin(), samples.end());
+        double total = 0;
+        for (double sample : samples) total += sample;
+        auto percentile = [&samples](double p) {
+            if (samples.empty()) return 0.0;
+            size_t index = static_cast<size_t>(p * (samples.size() - 1));
+            return samples[index];
+        };
+        double mean = samples.empty() ? 0 : total / samples.size();
+
+        out << (r ? ",\n" : "\n")
+            << "    {\"catalogSize\": " << results[r].catalogSize
+            << ", \"operation\": \"" << results[r].operation << "\""
+            << ", \"iterations\": " << samples.size()
+            << ", \"meanNs\": " << static_cast<long long>(mean)
+            << ", \"p50Ns\": " << static_cast<long long>(percentile(0.50))
+            << ", \"p90Ns\": " << static_cast<long long>(percentile(0.90))
+            << ", \"p99Ns\": " << static_cast<long long>(percentile(0.99))
+            << ", \"maxNs\": " << static_cast<long long>(percentile(1.0))
+            << ", \"opsPerSec\": " << static_cast<long long>(mean > 0 ? 1e9 / mean : 0)
+            << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+static void runCatalog(size_t catalogSize, size_t ops, vector<BenchmarkResult>& results) {
+    mt19937 rng(42);
+    auto pick = [&rng](const vector<string>& values) {
+        return values[rng() % values.size()];
+    };
+    auto record = [&results, catalogSize](const string& operation) -> BenchmarkResult& {
+        results.push_back({catalogSize, operation, {}});
+        return results.back();
+    };
+
+    // Load the (empty) scratch state first: that opens the journal, so the
+    // timed mutations pay for journaling as they do in production
+    Library library;
+    if (!library.loadState()) return;
+    cerr << "Catalog " << catalogSize << ": building" << endl;
+
+    measure(record("addBook"), catalogSize, [&](size_t i) {
+        int bookID = static_cast<int>(i + 1);
+        string title = pick(TITLE_WORDS) + " " + pick(TITLE_WORDS) + " " + pick(TITLE_WORDS);
+        library.addBook(make_unique<Book>(bookID, title, pick(AUTHOR_NAMES), pick(PUBLISHERS),
+                                          1950 + static_cast<int>(i % 70), "978-0-00-000000-0"));
+    });
+
+    // Faculty accounts: no fines, five books each
+    size_t userCount = max<size_t>(1000, catalogSize / 50);
+    for (size_t i = 0; i < userCount; ++i) {
+        auto user = make_unique<Faculty>(static_cast<int>(1000000 + i), "Bench User", "bench");
+        user->setDepartment("Benchmarks");
+        library.addUser(move(user));
+    }
+    auto randomUser = [&]() { return static_cast<int>(1000000 + rng() % userCount); };
+    auto randomBook = [&]() { return static_cast<int>(1 + rng() % catalogSize); };
+
+    cerr << "Catalog " << catalogSize << ": circulation" << endl;
+    measure(record("searchBooks"), ops, [&](size_t) {
+        library.searchBooks(pick(TITLE_WORDS) + " " + pick(TITLE_WORDS));
+    });
+
+    // Infixes are not index terms, so these take the substring scan path
+    measure(record("substringScan"), min<size_t>(ops, 100), [&](size_t) {
+        const string& word = pick(TITLE_WORDS);
+        library.searchBooks(word.substr(1, 3));
+    });
+
+    measure(record("autocomplete"), ops, [&](size_t) {
+        const string& word = pick(TITLE_WORDS);
+        library.autocomplete(word.substr(0, 1 + rng() % 3), 10);
+    });
+
+    measure(record("fuzzySearch"), ops, [&](size_t) {
+        string word = pick(TITLE_WORDS);
+        word[rng() % word.size()] = static_cast<char>('a' + rng() % 26);
+        library.fuzzySearch(word + " " + pick(AUTHOR_NAMES), 20);
+    });
+
+    measure(record("getBooksByPublisher"), min<size_t>(ops, 100), [&](size_t) {
+        library.getBooksByPublisher(pick(PUBLISHERS));
+    });
+
+    vector<pair<int, int>> loans;
+    measure(record("borrowBook"), ops, [&](size_t) {
+        int userID = randomUser();
+        int bookID = randomBook();
+        if (library.borrowBook(userID, bookID)) loans.push_back({userID, bookID});
+    });
+
+    measure(record("reserveBook"), min(ops, loans.size()), [&](size_t i) {
+        library.reserveBook(randomUser(), loans[i].second);
+    });
+
+    measure(record("getReservedBooks"), min<size_t>(ops, 100), [&](size_t) {
+        library.getReservedBooks(randomUser());
+    });
+
+    measure(record("getAllBorrowedBooks"), 10, [&](size_t) {
+        library.getAllBorrowedBooks();
+    });
+
+    // saveState only rewrites what changed, so write out the circulation
+    // phase untimed and then give every sample the same work: a fixed number
+    // of changed accounts (a zero payment marks an account without altering it)
+    cerr << "Catalog " << catalogSize << ": persistence" << endl;
+    library.saveState();
+    BenchmarkResult& saves = record("saveState");
+    for (size_t sample = 0; sample < 3; ++sample) {
+        for (size_t i = 0; i < SAVE_CHANGED_ACCOUNTS; ++i) {
+            library.payFine(static_cast<int>(1000000 + (sample * SAVE_CHANGED_ACCOUNTS + i) % userCount), 0);
+        }
+        measure(saves, 1, [&](size_t) {
+            library.saveState();
+        });
+    }
+
+    measure(record("loadState"), 3, [&](size_t) {
+        library.loadState();
+    });
+
+    // Returns run after the reload so they also cover the journaled path
+    measure(record("returnBook"), loans.size(), [&](size_t i) {
+        library.returnBook(loans[i].first, loans[i].second);
+    });
+}
+
+int main(int argc, char* argv[]) {
+    size_t ops = 100000;
+    vector<size_t> catalogSizes;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--ops" && i + 1 < argc) {
+            ops = stoull(argv[++i]);
+        } else {
+            catalogSizes.push_back(stoull(arg));
+        }
+    }
+    if (catalogSizes.empty()) catalogSizes.push_back(10000);
+
+    // Library persists under ./data, so run inside a scratch directory
+    filesystem::path scratch = filesystem::temp_directory_path() / "lms-benchmark";
+    filesystem::path originalDir = filesystem::current_path();
+
+    // The library reports progress on stdout; keep stdout for the JSON
+    streambuf* stdoutBuffer = cout.rdbuf(cerr.rdbuf());
+    vector<BenchmarkResult> results;
+    for (size_t catalogSize : catalogSizes) {
+        // Start every catalog from an empty data directory and journal
+        filesystem::current_path(originalDir);
+        filesystem::remove_all(scratch);
+        filesystem::create_directories(scratch / "data" / "accounts");
+        filesystem::current_path(scratch);
+        runCatalog(catalogSize, ops, results);
+    }
+    cout.rdbuf(stdoutBuffer);
+
+    filesystem::current_path(originalDir);
+    filesystem::remove_all(scratch);
+    writeJson(cout, results);
+    return 0;
+}
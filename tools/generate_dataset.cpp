@@ -0,0 +1,293 @@
+// Synthetic dataset generator for scale testing.
+//
+// Usage: generate_dataset [options]
+//   --out DIR              output directory (default: generated)
+//   --books N              catalog size (default: 100000)
+//   --students N           (default: 20000)
+//   --faculty N            (default: 2000)
+//   --librarians N         (default: 50)
+//   --years N              years of borrow history (default: 3)
+//   --history-per-year N   mean returned loans per patron per year (default: 6)
+//   --active-rate R        fraction of patrons with current loans (default: 0.3)
+//   --reservations N       reservation attempts (default: patrons / 20)
+//   --seed N               random seed (default: 42)
+//   --now T                time the loan dates are relative to, in Unix seconds
+//                          (default: 1767225600, i.e. 2026-01-01 UTC)
+//
+// Writes books.txt, students.txt, faculty.txt, librarians.txt,
+// reservations.txt and accounts/<userID>.txt in the formats Library reads.
+// Title words, authors and borrow popularity follow Zipf distributions, so
+// a few books are borrowed and reserved far more often than the rest. The
+// same seed and --now always produce the same dataset; pass --now $(date +%s)
+// for loans that are current today.
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+// Samples ranks 0..n-1 with probability proportional to 1 / (rank + 1)^s
+class ZipfSampler {
+private:
+    vector<double> cdf;
+
+public:
+    ZipfSampler(size_t n, double s) : cdf(n) {
+        double total = 0;
+        for (size_t rank = 0; rank < n; ++rank) {
+            total += 1.0 / pow(static_cast<double>(rank + 1), s);
+            cdf[rank] = total;
+        }
+        for (double& value : cdf) value /= total;
+    }
+
+    template<typename Rng>
+    size_t operator()(Rng& rng) const {
+        double u = uniform_real_distribution<double>(0.0, 1.0)(rng);
+        size_t rank = lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+        return min(rank, cdf.size() - 1);
+    }
+};
+
+struct Options {
+    string outDir = "generated";
+    size_t books = 100000;
+    size_t students = 20000;
+    size_t faculty = 2000;
+    size_t librarians = 50;
+    int years = 3;
+    double historyPerYear = 6;
+    double activeRate = 0.3;
+    size_t reservations = 0;
+    unsigned long long seed = 42;
+    long long now = 1767225600;
+};
+
+struct Patron {
+    int userID;
+    int maxBooks;
+    vector<int> currentBorrows;
+};
+
+static const vector<string> SYLLABLES = {
+    "ka", "ri", "mo", "an", "te", "la", "shi", "vi", "na", "de", "ra", "su",
+    "ma", "lo", "pe", "ya", "ki", "dha", "ru", "gan", "ti", "sa", "ve", "no"
+};
+
+static const vector<string> FIRST_NAMES = {
+    "Aarav", "Priya", "Rohan", "Ananya", "Vikram", "Meera", "Arjun", "Kavya",
+    "Rahul", "Sneha", "Aditya", "Isha", "Karan", "Divya", "Nikhil", "Pooja"
+};
+
+static const vector<string> LAST_NAMES = {
+    "Sharma", "Iyer", "Nair", "Reddy", "Gupta", "Das", "Menon", "Rao",
+    "Patel", "Singh", "Kulkarni", "Bose", "Pillai", "Joshi", "Verma", "Chatterjee"
+};
+
+static const vector<string> DEPARTMENTS = {
+    "Computer Science", "Electrical Engineering", "Mechanical Engineering", "Physics",
+    "Mathematics", "Chemistry", "Economics", "Humanities", "Civil Engineering", "Biology"
+};
+
+static const vector<string> PUBLISHERS = {
+    "Penguin India", "HarperCollins", "Rupa Publications", "Oxford University Press",
+    "Jonathan Cape", "Vintage", "Picador", "Orient BlackSwan", "Sahitya Akademi",
+    "Pan Macmillan", "Bloomsbury", "Westland", "Aleph Book Company", "Hachette India"
+};
+
+static string capitalize(string word) {
+    if (!word.empty()) word[0] = static_cast<char>(toupper(static_cast<unsigned char>(word[0])));
+    return word;
+}
+
+// Deterministic pseudo-word for vocabulary rank `rank`
+static string makeWord(size_t rank) {
+    string word;
+    size_t value = rank + SYLLABLES.size();
+    while (value > 0) {
+        word += SYLLABLES[value % SYLLABLES.size()];
+        value /= SYLLABLES.size();
+    }
+    return word;
+}
+
+// Hyphenated ISBN-13 with a valid check digit
+static string makeISBN(size_t bookIndex) {
+    string digits = "978" + to_string(1000000000ULL + bookIndex).substr(1);
+    int sum = 0;
+    for (size_t i = 0; i < 12; ++i) {
+        sum += (digits[i] - '0') * (i % 2 ? 3 : 1);
+    }
+    digits += static_cast<char>('0' + (10 - sum % 10) % 10);
+    return digits.substr(0, 3) + "-" + digits.substr(3, 1) + "-" + digits.substr(4, 4) +
+           "-" + digits.substr(8, 4) + "-" + digits.substr(12, 1);
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            return false;
+        }
+        string value = argv[++i];
+        if (arg == "--out") options.outDir = value;
+        else if (arg == "--books") options.books = stoull(value);
+        else if (arg == "--students") options.students = stoull(value);
+        else if (arg == "--faculty") options.faculty = stoull(value);
+        else if (arg == "--librarians") options.librarians = stoull(value);
+        else if (arg == "--years") options.years = stoi(value);
+        else if (arg == "--history-per-year") options.historyPerYear = stod(value);
+        else if (arg == "--active-rate") options.activeRate = stod(value);
+        else if (arg == "--reservations") options.reservations = stoull(value);
+        else if (arg == "--seed") options.seed = stoull(value);
+        else if (arg == "--now") options.now = stoll(value);
+        else {
+            cerr << "Unknown option " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options) || options.books == 0) {
+        cerr << "Usage: generate_dataset [--out DIR] [--books N] [--students N] [--faculty N]\n"
+                "                        [--librarians N] [--years N] [--history-per-year N]\n"
+                "                        [--active-rate R] [--reservations N] [--seed N]\n"
+                "                        [--now T]" << endl;
+        return 1;
+    }
+
+    mt19937_64 rng(options.seed);
+    filesystem::path out = options.outDir;
+    filesystem::create_directories(out / "accounts");
+
+    // Borrow popularity: rank -> bookID, shuffled so popular books are spread
+    // across the ID range
+    vector<int> bookByRank(options.books);
+    for (size_t i = 0; i < options.books; ++i) bookByRank[i] = static_cast<int>(i + 1);
+    shuffle(bookByRank.begin(), bookByRank.end(), rng);
+    ZipfSampler popularity(options.books, 1.0);
+    auto popularBook = [&]() { return bookByRank[popularity(rng)]; };
+
+    // Patrons: IDs are assigned sequentially from 100000 across roles
+    int nextUserID = 100000;
+    vector<Patron> patrons;
+    auto writeUsers = [&](const string& file, size_t count, int maxBooks) {
+        ofstream users(out / file);
+        ZipfSampler departmentSampler(DEPARTMENTS.size(), 1.0);
+        for (size_t i = 0; i < count; ++i) {
+            int userID = nextUserID++;
+            users << userID << "|" << FIRST_NAMES[rng() % FIRST_NAMES.size()] << " "
+                  << LAST_NAMES[rng() % LAST_NAMES.size()] << "|pw" << userID << "|"
+                  << (maxBooks ? DEPARTMENTS[departmentSampler(rng)] : "Library") << "\n";
+            patrons.push_back({userID, maxBooks, {}});
+        }
+    };
+    writeUsers("students.txt", options.students, 3);
+    writeUsers("faculty.txt", options.faculty, 5);
+    writeUsers("librarians.txt", options.librarians, 0);
+    cerr << "Wrote " << patrons.size() << " users" << endl;
+
+    // Current loans: each book is out to at most one patron
+    vector<int> borrowerOf(options.books + 1, 0);
+    for (auto& patron : patrons) {
+        if (patron.maxBooks == 0) continue;
+        if (uniform_real_distribution<double>(0.0, 1.0)(rng) >= options.activeRate) continue;
+        int wanted = 1 + static_cast<int>(rng() % patron.maxBooks);
+        for (int attempt = 0; attempt < wanted * 4 &&
+                              static_cast<int>(patron.currentBorrows.size()) < wanted; ++attempt) {
+            int bookID = popularBook();
+            if (borrowerOf[bookID] == 0) {
+                borrowerOf[bookID] = patron.userID;
+                patron.currentBorrows.push_back(bookID);
+            }
+        }
+    }
+
+    // Reservations: popular books that are out collect the deepest queues
+    size_t reservationAttempts = options.reservations ? options.reservations : patrons.size() / 20;
+    unordered_map<int, vector<int>> queues;
+    unordered_set<long long> queued;
+    ofstream reservations(out / "reservations.txt");
+    for (size_t i = 0; i < reservationAttempts && !patrons.empty(); ++i) {
+        const Patron& patron = patrons[rng() % patrons.size()];
+        int bookID = popularBook();
+        if (patron.maxBooks == 0 || borrowerOf[bookID] == 0 || borrowerOf[bookID] == patron.userID) {
+            continue;
+        }
+        long long key = (static_cast<long long>(bookID) << 32) | static_cast<unsigned>(patron.userID);
+        if (queued.insert(key).second) {
+            queues[bookID].push_back(patron.userID);
+            reservations << bookID << "|" << patron.userID << "\n";
+        }
+    }
+    cerr << "Wrote " << queued.size() << " reservations on " << queues.size() << " books" << endl;
+
+    // Catalog
+    ZipfSampler wordSampler(5000, 1.1);
+    ZipfSampler authorSampler(max<size_t>(options.books / 8, 1), 0.9);
+    ZipfSampler publisherSampler(PUBLISHERS.size(), 1.0);
+    ofstream books(out / "books.txt");
+    for (size_t i = 0; i < options.books; ++i) {
+        int bookID = static_cast<int>(i + 1);
+        int wordCount = 1 + static_cast<int>(rng() % 4);
+        string title;
+        for (int w = 0; w < wordCount; ++w) {
+            if (w) title += " ";
+            title += capitalize(makeWord(wordSampler(rng)));
+        }
+        size_t author = authorSampler(rng);
+        books << bookID << "|" << title << "|"
+              << FIRST_NAMES[author % FIRST_NAMES.size()] << " "
+              << capitalize(makeWord(author)) << "|"
+              << PUBLISHERS[publisherSampler(rng)] << "|"
+              << 1900 + static_cast<int>(rng() % 125) << "|"
+              << makeISBN(i) << "|" << (borrowerOf[bookID] ? 0 : 1) << "\n";
+    }
+    cerr << "Wrote " << options.books << " books" << endl;
+
+    // Accounts: current loans plus returned loans spread over the history window
+    const long long now = options.now;
+    const long long day = 24 * 60 * 60;
+    const long long loanPeriod = 30 * day;
+    poisson_distribution<int> historySize(options.historyPerYear * options.years);
+    for (const auto& patron : patrons) {
+        ofstream account(out / "accounts" / (to_string(patron.userID) + ".txt"));
+        double fine = 0;
+        if (patron.maxBooks > 0) {
+            for (int bookID : patron.currentBorrows) {
+                // One loan in ten is overdue by 1-10 days; the rest are within
+                // their 30-day loan period
+                long long age = rng() % 10 == 0 ? 31 + static_cast<long long>(rng() % 10)
+                                                : static_cast<long long>(rng() % 31);
+                long long borrowed = now - age * day;
+                account << "BORROW|" << bookID << "|" << borrowed << "|"
+                        << borrowed + loanPeriod << "\n";
+            }
+            int history = historySize(rng);
+            for (int h = 0; h < history; ++h) {
+                long long borrowed = now - static_cast<long long>(rng() % (options.years * 365 + 1)) * day
+                                         - loanPeriod;
+                account << "HISTORY|" << popularBook() << "|" << borrowed << "|"
+                        << borrowed + loanPeriod << "\n";
+            }
+            if (patron.maxBooks == 3 && rng() % 20 == 0) {
+                fine = 10.0 * static_cast<double>(1 + rng() % 30);
+            }
+        }
+        account << "FINE|" << fine << "\n";
+    }
+    cerr << "Wrote " << patrons.size() << " account files to " << (out / "accounts").string() << endl;
+    return 0;
+}